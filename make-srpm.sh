@@ -112,6 +112,7 @@ BuildRequires: glibc-static
 
 # the {cwe} field in --template option is supported since cppcheck-1.85
 Requires: cppcheck >= 1.85
+Requires: %{name}-common%{?_isa} = %{version}-%{release}
 
 # older versions of csdiff do not read CWE numbers from Cppcheck output
 Conflicts: csdiff < 1.8.0
@@ -120,8 +121,19 @@ Conflicts: csdiff < 1.8.0
 This package contains the cscppc compiler wrapper that runs cppcheck in
 background fully transparently.
 
+# all the wrappers are hard links to a single multi-call binary, which would
+# become separate copies of the binary if shipped in different packages
+%package common
+Summary: The multi-call binary shared by all the compiler wrappers
+
+%description common
+This package contains the multi-call binary of the cscppc, csclng, csgcca,
+and csmatch compiler wrappers, which selects the analyzer by the name it is
+executed by.
+
 %package -n csclng
 Summary: A compiler wrapper that runs Clang in background
+Requires: %{name}-common%{?_isa} = %{version}-%{release}
 Requires: clang
 Conflicts: csmock-plugin-clang < 1.5.0
 
@@ -131,6 +143,7 @@ in background fully transparently.
 
 %package -n csgcca
 Summary: A compiler wrapper that runs 'gcc -fanalyzer' in background
+Requires: %{name}-common%{?_isa} = %{version}-%{release}
 
 %description -n csgcca
 This package contains the csgcca compiler wrapper that runs 'gcc -fanalyzer'
@@ -138,6 +151,7 @@ in background fully transparently.
 
 %package -n csmatch
 Summary: A compiler wrapper that runs smatch in background
+Requires: %{name}-common%{?_isa} = %{version}-%{release}
 Requires: clang
 
 %description -n csmatch
@@ -184,27 +198,30 @@ do
 done
 
 %files
-%{_bindir}/cscppc
 %{_datadir}/cscppc
 %{_libdir}/cscppc
 %{_mandir}/man1/%{name}.1*
 %doc COPYING README
 
-%files -n csclng
+%files common
+%{_bindir}/cscppc
 %{_bindir}/csclng
 %{_bindir}/csclng++
+%{_bindir}/csgcca
+%{_bindir}/csmatch
+%doc COPYING README
+
+%files -n csclng
 %{_libdir}/csclng
 %{_mandir}/man1/csclng.1*
 %doc COPYING
 
 %files -n csgcca
-%{_bindir}/csgcca
 %{_libdir}/csgcca
 %{_mandir}/man1/csgcca.1*
 %doc COPYING
 
 %files -n csmatch
-%{_bindir}/csmatch
 %{_libdir}/csmatch
 %doc COPYING
 EOF
@@ -23,22 +23,83 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "cswrap-core.h"
+#include "cswrap-db.h"
+#include "cswrap-stats.h"
 #include "cswrap/src/cswrap-util.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 static volatile pid_t pid_compiler;
 static volatile pid_t pid_analyzer;
+static volatile pid_t pid_preprocessor;
+
+/* exit status of the analyzer once it has been reaped */
+static int status_analyzer;
+
+/* read ends of the pipes the output of the analyzer is relayed from */
+static int fd_diag_out = -1;
+static int fd_diag_err = -1;
+
+/* amount of the relayed output of the analyzer, accounted once it finishes */
+static long long diag_bytes;
+
+/* self-pipe written by the SIGCHLD handler to wake up the relay loop */
+static int fd_sigchld[2] = { -1, -1 };
+
+/* if set to a non-empty string, preprocess the input file only once */
+static const char *pponce_envvar_name = "CSCPPC_PREPROCESS_ONCE";
+
+/* the input file and its preprocessed image shared along a wrapper chain */
+static const char *pp_input_envvar_name = "CSCPPC_PP_INPUT";
+static const char *pp_file_envvar_name = "CSCPPC_PP_FILE";
+
+/* the compiler that has preprocessed the file, analyzers need to match it */
+static const char *pp_tool_envvar_name = "CSCPPC_PP_TOOL";
+
+/* read end of a pipe that is closed once the preprocessed file is complete */
+static const char *pp_ready_envvar_name = "CSCPPC_PP_READY_FD";
+
+/* write end of the above pipe in the wrapper that runs the preprocessor */
+static int fd_pp_ready = -1;
+
+/* if set to a non-empty string, terminate stale analyses of the same TU */
+static const char *supersede_envvar_name = "CSCPPC_SUPERSEDE_ANALYSIS";
+
+/* compilers resolved by the first wrapper in the chain for the other ones */
+static const char *resolved_envvar_name = "CSCPPC_RESOLVED";
+
+/* absolute path of the analyzer resolved earlier in the chain (if valid) */
+static char *analyzer_resolved;
+
+/* selects the profile if the binary is not executed by the name of one */
+static const char *profile_envvar_name = "CSCPPC_PROFILE";
+
+/* profile of the wrapper being run, selected at startup */
+const struct wrapper_profile *profile;
+
+/* base name of the binary being run, the same as wrapper_name if linked */
+static char *self_name;
+
+/* output of the analyzer captured for the cross-function database */
+static const char *db_dir;
+static char *db_input;
+static char *db_out_file;
 
 /* print error and return EXIT_FAILURE */
 static int fail(const char *fmt, ...)
@@ -46,7 +107,8 @@ static int fail(const char *fmt, ...)
     va_list ap;
     va_start(ap, fmt);
 
-    fprintf(stderr, "%s: error: ", wrapper_name);
+    fprintf(stderr, "%s: error: ",
+            (profile) ? profile->wrapper_name : self_name);
     vfprintf(stderr, fmt, ap);
     fputc('\n', stderr);
 
@@ -54,19 +116,34 @@ static int fail(const char *fmt, ...)
     return EXIT_FAILURE;
 }
 
+/* the initial value of the hash to be passed to hash_str() (FNV-1a basis) */
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+static unsigned long long hash_str(unsigned long long hash, const char *str)
+{
+    /* FNV-1a, including the terminating NUL */
+    do {
+        hash ^= (unsigned char) *str;
+        hash *= 0x100000001b3ULL;
+    } while (*str++);
+
+    return hash;
+}
+
 static int usage(char *argv[])
 {
     /* FIXME: move this to the internal API */
-    const char *tool_name = (STREQ(analyzer_name, "gcc"))
+    const char *tool_name = (STREQ(profile->analyzer_name, "gcc"))
         ? "gcc -fanalyzer"
-        : analyzer_name;
+        : profile->analyzer_name;
 
+    const char *name = profile->wrapper_name;
     fprintf(stderr, "Usage:\n\
     export PATH=\"`%s --print-path-to-wrap`:$PATH\"\n\n\
     %s is a compiler wrapper that runs %s in background.  Create\n\
     a symbolic link to %s named as your compiler (gcc, g++, ...) and put it\n\
     to your $PATH.  %s --help prints this text to standard error output.\n",
-    wrapper_name, wrapper_name, tool_name, wrapper_name, wrapper_name);
+    name, name, tool_name, name, name);
 
     for (; *argv; ++argv)
         if (STREQ("--help", *argv))
@@ -77,13 +154,204 @@ static int usage(char *argv[])
     return EXIT_FAILURE;
 }
 
+/* deferred jobs are run the same way as the analyzer during the build */
+static pid_t launch_tool(
+        const char                 *tool,
+        char                      **argv,
+        const char                **del_args,
+        const bool                  quiet,
+        const int                   fd_out,
+        const int                   fd_err,
+        const bool                  own_group);
+static int wait_for(const pid_t pid);
+static void create_diag_pipes(int *pfd_out, int *pfd_err);
+static bool relay_available(void);
+static void relay_diagnostics(void);
+
+/* read a queued job and run the analyzer (in a child process) */
+static int run_deferred_job(const char *job)
+{
+    FILE *fp = fopen(job, "r");
+    if (!fp)
+        return fail("failed to open '%s' (%s)", job, strerror(errno));
+
+    /* read NUL-terminated strings: working directory, analyzer, args... */
+    char **argv = NULL;
+    size_t argc = 0;
+    char *str = NULL;
+    size_t len = 0;
+    while (-1 != getdelim(&str, &len, '\0', fp)) {
+        char **argv_new = realloc(argv, (argc + 2) * sizeof(char *));
+        if (!argv_new)
+            return fail("realloc() failed");
+
+        argv = argv_new;
+        argv[argc++] = str;
+        str = NULL;
+        len = 0;
+    }
+
+    free(str);
+    fclose(fp);
+
+    /* the job has been consumed */
+    unlink(job);
+
+    if (argc < 2)
+        return fail("invalid job file '%s'", job);
+
+    argv[argc] = NULL;
+    if (chdir(argv[0]))
+        return fail("failed to enter '%s' (%s)", argv[0], strerror(errno));
+
+    if (!stats_enabled()) {
+        /* nothing to account for --> just replace this process */
+        execvp(argv[1], argv + 1);
+        fail("failed to exec '%s' (%s)", argv[1], strerror(errno));
+        return (ENOENT == errno)
+                ? /* command not found      */ 0x7F
+                : /* command not executable */ 0x7E;
+    }
+
+    int fd_out = -1, fd_err = -1;
+    create_diag_pipes(&fd_out, &fd_err);
+    pid_analyzer = launch_tool(argv[1], argv + 1, /* del_args */ NULL,
+            /* quiet */ false, fd_out, fd_err, /* own_group */ true);
+    if (0 < pid_analyzer)
+        stats_analyzer_started();
+
+    if (0 <= fd_out)
+        close(fd_out);
+    if (0 <= fd_err)
+        close(fd_err);
+
+    relay_diagnostics();
+
+    return (0 < pid_analyzer)
+        ? wait_for(pid_analyzer)
+        : EXIT_FAILURE;
+}
+
+/* wait for any job to finish, return true if it has succeeded */
+static bool wait_for_any(void)
+{
+    int status;
+    while (-1 == wait(&status))
+        if (EINTR != errno)
+            return false;
+
+    /* the analyzer could not be executed or it was terminated by a signal */
+    return WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+/* run the deep analysis jobs queued during the build, max_jobs in parallel */
+static int run_deferred(long max_jobs)
+{
+    if (max_jobs < 1)
+        /* sysconf() failed */
+        max_jobs = 1;
+
+    const char *queue_dir = getenv(profile->wrapper_defer_envvar_name);
+    if (!queue_dir || !queue_dir[0])
+        return fail("%s is not set", profile->wrapper_defer_envvar_name);
+
+    DIR *dir = opendir(queue_dir);
+    if (!dir)
+        return fail("failed to open '%s' (%s)", queue_dir, strerror(errno));
+
+    long running = 0;
+    long failed = 0;
+    const struct dirent *de;
+    while ((de = readdir(dir))) {
+        const char *name = de->d_name;
+        const size_t len = strlen(name);
+        if (len < 4 || !STREQ(name + len - 4, ".job"))
+            /* not a job file */
+            continue;
+
+        char *job, *job_run;
+        if (asprintf(&job, "%s/%s", queue_dir, name) < 0)
+            continue;
+        if (asprintf(&job_run, "%s.run", job) < 0) {
+            free(job);
+            continue;
+        }
+
+        /* claim the job so that parallel batch runs do not run it twice */
+        const bool claimed = !rename(job, job_run);
+        free(job);
+        if (!claimed) {
+            free(job_run);
+            continue;
+        }
+
+        stats_add(STATS_ANALYZERS_QUEUED, -1);
+
+        for (; max_jobs <= running; --running)
+            failed += !wait_for_any();
+
+        const pid_t pid = fork();
+        if (pid == 0)
+            exit(run_deferred_job(job_run));
+
+        if (pid < 0) {
+            fail("failed to fork() for '%s' (%s)", job_run, strerror(errno));
+            ++failed;
+        }
+        else
+            ++running;
+
+        free(job_run);
+    }
+
+    closedir(dir);
+
+    /* wait for the remaining jobs to finish */
+    for (; 0 < running; --running)
+        failed += !wait_for_any();
+
+    if (failed)
+        return fail("%ld deferred job(s) failed", failed);
+
+    return EXIT_SUCCESS;
+}
+
 static int handle_args(const int argc, char *argv[])
 {
     if (argc == 2 && STREQ("--print-path-to-wrap", argv[1])) {
-        printf("%s\n", wrapper_path);
+        printf("%s\n", profile->wrapper_path);
         return EXIT_SUCCESS;
     }
 
+    if (argc == 2 && profile->analyzer_db_envvar_name
+            && STREQ("--update-db", argv[1]))
+    {
+        const char *var_db_dir = getenv(profile->analyzer_db_envvar_name);
+        if (!var_db_dir || !var_db_dir[0])
+            return fail("%s is not set", profile->analyzer_db_envvar_name);
+
+        return db_update(var_db_dir);
+    }
+
+    if (argc == 2 && STREQ("--stats", argv[1]))
+        return stats_print();
+
+    if (argc == 2 && STREQ("--stats-remove", argv[1]))
+        return stats_remove();
+
+    if (argc == 2 && STREQ("--run-deferred", argv[1]))
+        return run_deferred(sysconf(_SC_NPROCESSORS_ONLN));
+
+    if (argc == 2 && MATCH_PREFIX(argv[1], "--run-deferred=")) {
+        const char *jobs = argv[1] + sizeof("--run-deferred=") - 1U;
+        char *end;
+        const long max_jobs = strtol(jobs, &end, 10);
+        if (*end || max_jobs < 1)
+            return fail("invalid number of jobs: %s", jobs);
+
+        return run_deferred(max_jobs);
+    }
+
     return usage(argv);
 }
 
@@ -95,20 +363,24 @@ static void signal_forwarder(int signum)
         kill(pid_compiler, signum);
 
     if (0 < pid_analyzer)
-        kill(pid_analyzer, signum);
+        /* the analyzer runs in its own process group */
+        kill(-pid_analyzer, signum);
+
+    if (0 < pid_preprocessor)
+        kill(pid_preprocessor, signum);
 
     errno = saved_errno;
 }
 
+static int forwarded_signals[] = {
+    SIGINT,
+    SIGQUIT,
+    SIGTERM,
+    /* list terminator */ 0
+};
+
 static bool install_signal_forwarder(void)
 {
-    static int forwarded_signals[] = {
-        SIGINT,
-        SIGQUIT,
-        SIGTERM,
-        /* list terminator */ 0
-    };
-
     return install_signal_handler(signal_forwarder, forwarded_signals);
 }
 
@@ -131,15 +403,62 @@ static void apply_del_arg(char **argv, const char *del_arg)
     }
 }
 
-static pid_t launch_tool(const char *tool, char **argv, const char **del_args)
+static pid_t launch_tool(
+        const char                 *tool,
+        char                      **argv,
+        const char                **del_args,
+        const bool                  quiet,
+        const int                   fd_out,
+        const int                   fd_err,
+        const bool                  own_group)
 {
+    /* block the forwarded signals until the child restores their handlers */
+    sigset_t mask, mask_orig;
+    sigemptyset(&mask);
+    const int *psig;
+    for (psig = forwarded_signals; *psig; ++psig)
+        sigaddset(&mask, *psig);
+    sigprocmask(SIG_BLOCK, &mask, &mask_orig);
+
     const pid_t pid = fork();
     if (pid < 0)
         fail("failed to fork() for '%s' (%s)", tool, strerror(errno));
 
-    if (pid != 0)
+    if (pid != 0) {
         /* either fork() failure, or continuation of the parental process */
+        if (0 < pid && own_group)
+            /* make sure the group exists before we signal it */
+            setpgid(pid, pid);
+
+        sigprocmask(SIG_SETMASK, &mask_orig, NULL);
         return pid;
+    }
+
+    if (own_group)
+        /* let us signal all processes of the tool, e.g. cc1 run by gcc */
+        setpgid(0, 0);
+
+    /* a signal sent to the child before exec would be lost otherwise */
+    for (psig = forwarded_signals; *psig; ++psig)
+        signal(*psig, SIG_DFL);
+    sigprocmask(SIG_SETMASK, &mask_orig, NULL);
+
+    if (0 <= fd_out)
+        /* redirect standard output to the given file */
+        dup2(fd_out, STDOUT_FILENO);
+
+    if (0 <= fd_err)
+        /* redirect standard error output to the given file */
+        dup2(fd_err, STDERR_FILENO);
+
+    if (quiet) {
+        /* the compiler is going to report the same errors again anyway */
+        const int fd = open("/dev/null", O_WRONLY);
+        if (0 <= fd) {
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+    }
 
     if (del_args) {
         /* remove del_args from argv for this invocation only */
@@ -155,15 +474,40 @@ static pid_t launch_tool(const char *tool, char **argv, const char **del_args)
             : /* command not executable */ 0x7E);
 }
 
+static int exit_status(const siginfo_t *si)
+{
+    switch (si->si_code) {
+        case CLD_KILLED:
+        case CLD_DUMPED:
+            /* terminated by a signal */
+            return 0x80 + si->si_status;
+
+        case CLD_EXITED:
+            /* terminated by a call to _exit() */
+        default:
+            return si->si_status;
+    }
+}
+
 static int wait_for(const pid_t pid)
 {
     for (;;) {
+        /* relay output of the analyzer (if any) while waiting */
+        const bool relay = (0 <= fd_diag_out || 0 <= fd_diag_err);
+
         siginfo_t si;
-        while (-1 == waitid(P_ALL, 0, &si, WEXITED))
+        si.si_pid = 0;
+        while (-1 == waitid(P_ALL, 0, &si, WEXITED | (relay ? WNOHANG : 0)))
             if (EINTR != errno)
                 return fail("waitid() failed while waiting for %d: %s", pid,
                         strerror(errno));
 
+        if (!si.si_pid) {
+            /* no child has finished yet --> relay until SIGCHLD arrives */
+            relay_available();
+            continue;
+        }
+
         switch (si.si_code) {
             case CLD_STOPPED:
             case CLD_CONTINUED:
@@ -174,34 +518,187 @@ static int wait_for(const pid_t pid)
                 break;
         }
 
+        const int status = exit_status(&si);
+        const bool analyzer = (pid_analyzer == si.si_pid);
+        stats_child_reaped(analyzer, status);
+
         if (pid_compiler == si.si_pid)
             pid_compiler = 0;
 
-        if (pid_analyzer == si.si_pid)
+        if (analyzer) {
+            /* the analyzer may finish while we are waiting for the compiler */
+            status_analyzer = status;
             pid_analyzer = 0;
+        }
+
+        if (pid == si.si_pid)
+            return status;
+    }
+}
+
+/* create a pipe to relay output of the analyzer, return its write end */
+static int create_diag_pipe(int *pfd_read)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC))
+        return -1;
+
+    *pfd_read = fds[0];
+    return fds[1];
+}
+
+static void sigchld_handler(int signum)
+{
+    (void) signum;
+    const int saved_errno = errno;
+    const char c = '\0';
+    if (write(fd_sigchld[1], &c, 1) < 0) {
+        /* the pipe is full --> the relay loop is going to wake up anyway */
+    }
+
+    errno = saved_errno;
+}
+
+/* make SIGCHLD interrupt poll() in relay_available() */
+static bool install_sigchld_handler(void)
+{
+    if (0 <= fd_sigchld[0])
+        /* already installed */
+        return true;
+
+    if (pipe2(fd_sigchld, O_CLOEXEC | O_NONBLOCK))
+        return false;
+
+    struct sigaction sa = {
+        .sa_handler = sigchld_handler,
+        .sa_flags = SA_RESTART | SA_NOCLDSTOP,
+    };
+    sigemptyset(&sa.sa_mask);
+    if (!sigaction(SIGCHLD, &sa, NULL))
+        return true;
+
+    close(fd_sigchld[0]);
+    close(fd_sigchld[1]);
+    fd_sigchld[0] = -1;
+    fd_sigchld[1] = -1;
+    return false;
+}
+
+/* pass output of the analyzer through pipes to count it (if enabled) */
+static void create_diag_pipes(int *pfd_out, int *pfd_err)
+{
+    if (!stats_enabled() || !install_sigchld_handler())
+        /* the pipes would not be relayed while waiting for the compiler */
+        return;
+
+    if (*pfd_out < 0)
+        *pfd_out = create_diag_pipe(&fd_diag_out);
+
+    *pfd_err = create_diag_pipe(&fd_diag_err);
+}
+
+static void write_all(const int fd, const char *buf, size_t len)
+{
+    while (len) {
+        const ssize_t written = write(fd, buf, len);
+        if (written < 0) {
+            if (EINTR == errno)
+                continue;
+
+            return;
+        }
+
+        buf += written;
+        len -= written;
+    }
+}
+
+/*
+ * Copy the output of the analyzer that is available to ours.  Block until
+ * there is some output, the pipes are closed, or SIGCHLD arrives.  Return
+ * false if all the pipes have been closed already.
+ */
+static bool relay_available(void)
+{
+    int *const pfd_src[] = {
+        &fd_diag_out,
+        &fd_diag_err,
+    };
+    const int fd_dst[] = {
+        STDOUT_FILENO,
+        STDERR_FILENO,
+    };
+
+    /* negative file descriptors are ignored by poll() */
+    struct pollfd pfd[] = {
+        { .fd = fd_diag_out,   .events = POLLIN },
+        { .fd = fd_diag_err,   .events = POLLIN },
+        { .fd = fd_sigchld[0], .events = POLLIN },
+    };
 
-        if (pid != si.si_pid)
+    if (pfd[0].fd < 0 && pfd[1].fd < 0)
+        return false;
+
+    int i;
+    if (poll(pfd, 3, -1) < 0) {
+        if (EINTR == errno)
+            return true;
+
+        /* give up relaying, the analyzer gets SIGPIPE if it writes more */
+        for (i = 0; i < 2; ++i) {
+            if (0 <= *pfd_src[i])
+                close(*pfd_src[i]);
+            *pfd_src[i] = -1;
+        }
+
+        return false;
+    }
+
+    if (pfd[2].revents) {
+        /* consume the wake-up calls, the caller checks for finished children */
+        char buf[64];
+        while (0 < read(fd_sigchld[0], buf, sizeof buf))
+            ;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        if (pfd[i].fd < 0 || !pfd[i].revents)
             continue;
 
-        switch (si.si_code) {
-            case CLD_KILLED:
-            case CLD_DUMPED:
-                /* terminated by a signal */
-                return 0x80 + si.si_status;
+        char buf[4096];
+        const ssize_t len = read(pfd[i].fd, buf, sizeof buf);
+        if (len < 0 && EINTR == errno)
+            continue;
 
-            case CLD_EXITED:
-                /* terminated by a call to _exit() */
-            default:
-                return si.si_status;
+        if (len <= 0) {
+            /* end of output */
+            close(pfd[i].fd);
+            *pfd_src[i] = -1;
+            continue;
         }
+
+        write_all(fd_dst[i], buf, len);
+        diag_bytes += len;
     }
+
+    return true;
+}
+
+/* copy output of the analyzer to ours until all the pipes are closed */
+static void relay_diagnostics(void)
+{
+    while (relay_available())
+        ;
+
+    stats_add(STATS_DIAG_BYTES, diag_bytes);
+    diag_bytes = 0;
 }
 
 static bool is_def_inc(const char *arg)
 {
     return MATCH_PREFIX(arg, "-D")
         || MATCH_PREFIX(arg, "-I")
-        || (analyzer_is_gcc_compatible
+        || (profile->analyzer_is_gcc_compatible
                 && (STREQ(arg, "-include")
                     || STREQ(arg, "-iquote")
                     || STREQ(arg, "-isystem")));
@@ -211,7 +708,7 @@ static bool is_bare_def_inc(const char *arg)
 {
     return STREQ(arg, "-D")
         || STREQ(arg, "-I")
-        || (analyzer_is_gcc_compatible
+        || (profile->analyzer_is_gcc_compatible
                 && (STREQ(arg, "-include")
                     || STREQ(arg, "-iquote")
                     || STREQ(arg, "-isystem")));
@@ -228,7 +725,7 @@ static bool is_forwardable_gcc_flag(const char *arg)
     if (MATCH_PREFIX(arg, "-O") || MATCH_PREFIX(arg, "-std"))
         return true;
 
-    if (STREQ(analyzer_name, "gcc")) {
+    if (STREQ(profile->analyzer_name, "gcc")) {
         /* pass all -f* flags to gcc analyzer to avoid spurious warnings */
         if (MATCH_PREFIX(arg, "-f"))
             return true;
@@ -251,7 +748,11 @@ static int /* args remain */ drop_arg(int *pargc, char **argv, const int i)
     return args_remain;
 }
 
-static int translate_args_for_analyzer(int argc, char **argv)
+/* count_skips is false if the analyzer is not going to be started anyway */
+static int translate_args_for_analyzer(
+        int                         argc,
+        char                      **argv,
+        const bool                  count_skips)
 {
     int cnt_files = 0;
 
@@ -260,11 +761,11 @@ static int translate_args_for_analyzer(int argc, char **argv)
         const char *arg = argv[i];
         if (STREQ(arg, "-E"))
             /* preprocessing --> bypass analyzer in order to not break ccache */
-            return -1;
+            goto skip_preprocess_only;
 
         if (MATCH_PREFIX(arg, "-M"))
             /* tracking includes --> bypass the analyzer to save resources */
-            return -1;
+            goto skip_deps_only;
 
         if (is_def_inc(arg)) {
             if (is_bare_def_inc(arg))
@@ -275,17 +776,17 @@ static int translate_args_for_analyzer(int argc, char **argv)
             continue;
         }
 
-        if (is_input_file(arg, analyzer_is_cxx_ready)) {
+        if (is_input_file(arg, profile->analyzer_is_cxx_ready)) {
             if (is_ignored_file(arg))
                 /* ignored input file --> do not start analyzer */
-                return -1;
+                goto skip_ignored_file;
 
             /* pass input file name as it is */
             ++cnt_files;
             continue;
         }
 
-        if (analyzer_is_gcc_compatible) {
+        if (profile->analyzer_is_gcc_compatible) {
             if (is_forwardable_gcc_flag(arg))
                 /* pass -m{16,32,64} and the like directly to the analyzer */
                 continue;
@@ -319,131 +820,1022 @@ drop_it:
         drop_arg(&argc, argv, i--);
     }
 
-    if (!cnt_files)
-        /* no input files, giving up... */
-        return -1;
+    if (cnt_files)
+        return argc;
 
-    return argc;
-}
+    /* no input files, giving up... */
+    if (count_skips)
+        stats_add(STATS_SKIP_NO_INPUT, 1);
+    return -1;
 
-static int num_custom_opts(const char *str)
-{
-    if (!str || !str[0])
-        return 0;
+skip_preprocess_only:
+    if (count_skips)
+        stats_add(STATS_SKIP_PREPROCESS_ONLY, 1);
+    return -1;
 
-    int num;
-    for (num = 1; NULL != (str = strchr(str, ':')); ++num)
-        ++str;
+skip_deps_only:
+    if (count_skips)
+        stats_add(STATS_SKIP_DEPS_ONLY, 1);
+    return -1;
 
-    return num;
+skip_ignored_file:
+    if (count_skips)
+        stats_add(STATS_SKIP_IGNORED_FILE, 1);
+    return -1;
 }
 
-static bool read_custom_opts(char **dst, const char *str)
+/* return the only input file to be analyzed, NULL otherwise */
+static const char *find_single_input(const int argc, char **argv)
 {
-    if (!str || !str[0])
-        return true;
+    const char *input = NULL;
 
-    /* go through all options separated by ':' */
-    for (;;) {
-        const char *term = strchr(str, ':');
-        if (!term)
-            /* this was the last option */
-            return (*dst = strdup(str));
+    int i;
+    for (i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (is_bare_def_inc(arg)) {
+            /* skip the argument of bare -D or -I */
+            ++i;
+            continue;
+        }
 
-        /* allocate memory for the option in the dst array */
-        const size_t len = term - str;
-        *dst = malloc(len + /* for NUL */ 1);
-        if (!*dst)
-            return /* OOM */ false;
+        if (!is_input_file(arg, profile->analyzer_is_cxx_ready))
+            continue;
 
-        /* copy single option to the dst array */
-        memcpy(*dst, str, len);
-        (*dst)[len] = '\0';
+        if (input)
+            /* more than one input file */
+            return NULL;
 
-        /* move the cursor and jump to the next option */
-        ++dst;
-        str = term + 1;
+        input = arg;
     }
+
+    return input;
 }
 
-static void consider_running_analyzer(
-        const int                   argc_orig,
-        char **const                argv_orig)
+/* flags that affect preprocessing and take the next arg as their value */
+static bool is_bare_pp_flag(const char *arg)
 {
-    /* clone the argv array */
-    size_t argv_size = (argc_orig + 1) * sizeof(char *);
-    char **argv = malloc(argv_size);
-    if (!argv)
-        /* OOM */
-        return;
-    memcpy(argv, argv_orig, argv_size);
-
-    /* translate cmd-line args for analyzer */
-    const int argc_cmd = translate_args_for_analyzer(argc_orig, argv);
-    if (argc_cmd <= 0) {
-        /* do not start analyzer */
-        free(argv);
-        return;
-    }
+    return STREQ(arg, "-D")
+        || STREQ(arg, "-U")
+        || STREQ(arg, "-I")
+        || STREQ(arg, "-include")
+        || STREQ(arg, "-imacros")
+        || STREQ(arg, "-iquote")
+        || STREQ(arg, "-isystem")
+        || STREQ(arg, "-idirafter")
+        || STREQ(arg, "-isysroot")
+        || STREQ(arg, "--sysroot");
+}
 
-    /* count custom analyzer args (read from env var) */
-    const char *var_add_opts = getenv(wrapper_addopts_envvar_name);
-    const int argc_custom = num_custom_opts(var_add_opts);
+/* flags that affect preprocessing (predefined macros, include paths, ...) */
+static bool is_pp_flag(const char *arg)
+{
+    return is_bare_pp_flag(arg)
+        || MATCH_PREFIX(arg, "-D")
+        || MATCH_PREFIX(arg, "-U")
+        || MATCH_PREFIX(arg, "-I")
+        || MATCH_PREFIX(arg, "-O")
+        || MATCH_PREFIX(arg, "-f")
+        || MATCH_PREFIX(arg, "-m")
+        || MATCH_PREFIX(arg, "-std")
+        || MATCH_PREFIX(arg, "-nostdinc")
+        || MATCH_PREFIX(arg, "--sysroot=")
+        || STREQ(arg, "-ansi")
+        || STREQ(arg, "-pthread");
+}
 
-    const int argc_total = argc_cmd + analyzer_def_argc + argc_custom;
-    if (argc_orig < argc_total) {
-        /* enlarge the argv array */
-        argv_size = (argc_total + 1) * sizeof(char *);
-        char **argv_new = realloc(argv, argv_size);
-        if (!argv_new) {
-            /* OOM */
-            free(argv);
-            return;
-        }
-        argv = argv_new;
+/* create an empty temporary file for the preprocessed input, prefer tmpfs */
+static char *create_pp_file(const char *input)
+{
+    const char *tmp_dir = "/dev/shm";
+    if (access(tmp_dir, W_OK | X_OK)) {
+        tmp_dir = getenv("TMPDIR");
+        if (!tmp_dir || !tmp_dir[0])
+            tmp_dir = "/tmp";
     }
 
-    /* append default analyzer args */
-    char **argv_now = argv + argc_cmd;
-    memcpy(argv_now, analyzer_def_argv, analyzer_def_argc * sizeof(char *));
-    argv_now += analyzer_def_argc - /* terminating NULL */1;
-
-    /* append custom analyzer args (read from env var) if any */
-    if (!read_custom_opts(argv_now, var_add_opts)) {
-        free(argv);
-        return;
+    /* analyzers do not preprocess *.i and *.ii files again */
+    const char *suffix = strrchr(input, '.');
+    if (!suffix || strchr(suffix, '/'))
+        return NULL;
+    else if (STREQ(suffix, ".c"))
+        suffix = ".i";
+    else if (STREQ(suffix, ".C") || STREQ(suffix, ".cc")
+            || STREQ(suffix, ".cpp") || STREQ(suffix, ".cxx"))
+        suffix = ".ii";
+    else
+        return NULL;
+
+    char *pp_file;
+    if (asprintf(&pp_file, "%s/%s-XXXXXX%s", tmp_dir, profile->wrapper_name,
+                suffix) < 0)
+        return NULL;
+
+    const int fd = mkstemps(pp_file, strlen(suffix));
+    if (fd < 0) {
+        free(pp_file);
+        return NULL;
     }
 
-    const char *analyzer_name_actual = NULL;
-    if (analyzer_bin_envvar_name)
-        analyzer_name_actual = getenv(analyzer_bin_envvar_name);
-    if (!analyzer_name_actual || !analyzer_name_actual[0])
-        analyzer_name_actual = analyzer_name;
+    close(fd);
+    return pp_file;
+}
 
-    /* make sure that the analyzer process is named analyzer_name_actual */
-    argv[0] = (char *) analyzer_name_actual;
+static const struct wrapper_profile *find_profile(const char *name);
+static char *find_in_path(const char *tool, const char *path);
 
-    /* make sure there is NULL at the end of argv[] */
-    argv[argc_total - 1] = NULL;
+/* return name (or path) of the analyzer binary of the profile */
+static const char *analyzer_of(const struct wrapper_profile *p)
+{
+    const char *analyzer = NULL;
+    if (p->analyzer_bin_envvar_name)
+        analyzer = getenv(p->analyzer_bin_envvar_name);
+    if (!analyzer || !analyzer[0])
+        analyzer = p->analyzer_name;
 
-    const char *var_debug = getenv(wrapper_debug_envvar_name);
-    if (var_debug && *var_debug) {
-        /* run-time debugging enabled */
+    return analyzer;
+}
+
+/* return true if both the paths refer to the same file */
+static bool is_same_file(const char *path1, const char *path2)
+{
+    struct stat st1, st2;
+    return !stat(path1, &st1) && !stat(path2, &st2)
+        && (st1.st_dev == st2.st_dev)
+        && (st1.st_ino == st2.st_ino);
+}
+
+/*
+ * Return true if the analyzer of the profile, looked up in path, reads the
+ * file preprocessed by pp_tool.  The front end of the analyzer needs to be
+ * the preprocessor itself.  Otherwise the predefined macros would not match.
+ */
+static bool reads_pp_input(
+        const struct wrapper_profile   *p,
+        const char                     *path,
+        const char                     *pp_tool)
+{
+    if (!p || !p->analyzer_reads_pp_input || !path || !pp_tool)
+        return false;
+
+    /* the info for the database needs to refer to the original file */
+    const char *var_db_dir = (p->analyzer_db_envvar_name)
+        ? getenv(p->analyzer_db_envvar_name)
+        : NULL;
+    if (var_db_dir && var_db_dir[0])
+        return false;
+
+    const char *analyzer = analyzer_of(p);
+    char *file = (strchr(analyzer, '/'))
+        ? strdup(analyzer)
+        : find_in_path(analyzer, path);
+
+    const bool match = file && is_same_file(file, pp_tool);
+    free(file);
+    return match;
+}
+
+/*
+ * Return the compiler at the end of the chain of wrappers, which was resolved
+ * by resolve_compiler_chain(), and count the analyzers of this wrapper and of
+ * the wrappers chained after it that read the input preprocessed by it.
+ */
+static char *find_pp_tool(const char *tool, const char *compiler, int *pnum)
+{
+    const char *path = getenv("PATH");
+    char *pp_tool = (strchr(compiler, '/') || !path)
+        ? strdup(compiler)
+        : find_in_path(compiler, path);
+    if (!pp_tool)
+        return NULL;
+
+    /* the wrappers chained after this one and their sanitized $PATH */
+    const char *records = getenv(resolved_envvar_name);
+    char *buf = (records) ? strdup(records) : NULL;
+    char **wraps = NULL;
+    char **paths = NULL;
+    int cnt = 0;
+    char *line, *cursor = buf;
+    while (buf && (line = strsep(&cursor, "\n"))) {
+        const char *wrap      = strsep(&line, "\t");
+        const char *tool_now  = strsep(&line, "\t");
+        const char *path_hash = strsep(&line, "\t");
+        const char *path_next = strsep(&line, "\t");
+        const char *file      = strsep(&line, "\t");
+        if (!path_hash || !file || !STREQ(tool_now, tool))
+            continue;
+
+        const bool self = STREQ(wrap, profile->wrapper_name);
+        if (self)
+            /* consider only the wrappers chained after this one */
+            cnt = 0;
+
+        char **wraps_new = realloc(wraps, (cnt + 1) * sizeof(char *));
+        if (wraps_new)
+            wraps = wraps_new;
+        char **paths_new = realloc(paths, (cnt + 1) * sizeof(char *));
+        if (paths_new)
+            paths = paths_new;
+        if (!wraps_new || !paths_new)
+            break;
+
+        if (!self) {
+            wraps[cnt] = (char *) wrap;
+            paths[cnt] = (char *) path_next;
+            ++cnt;
+        }
+
+        /* the next hop of the last wrapper in the chain is the compiler */
+        char *pp_tool_next = strdup(file);
+        if (pp_tool_next) {
+            free(pp_tool);
+            pp_tool = pp_tool_next;
+        }
+    }
+
+    int num = reads_pp_input(profile, path, pp_tool);
+    int i;
+    for (i = 0; i < cnt; ++i)
+        num += reads_pp_input(find_profile(wraps[i]), paths[i], pp_tool);
+
+    free(paths);
+    free(wraps);
+    free(buf);
+    *pnum = num;
+    return pp_tool;
+}
+
+/*
+ * If the preprocess-once mode is enabled and any analyzer in the chain is
+ * going to read the preprocessed file, start preprocessing of the input file
+ * by the compiler at the end of the chain into a temporary *.i or *.ii file.
+ * Export its name for the analyzers of this wrapper and of all the wrappers
+ * chained after it.  The preprocessor runs in parallel with the compiler.
+ * The wrappers chained after this one wait for it to finish by reading the
+ * pipe given by pp_ready_envvar_name.
+ *
+ * Returns the name of the temporary file, which is up to the caller to remove
+ * once finish_preprocessing() has been called, or NULL if not preprocessing.
+ */
+static char *start_preprocessing(
+        const char                 *tool,
+        const int                   argc_orig,
+        char                      **argv_orig)
+{
+    const char *var_pponce = getenv(pponce_envvar_name);
+    if (!var_pponce || !var_pponce[0])
+        /* preprocess-once mode not enabled */
+        return NULL;
+
+    if (getenv(pp_file_envvar_name))
+        /* already preprocessed by a wrapper earlier in the chain */
+        return NULL;
+
+    int num_readers;
+    char *pp_tool = find_pp_tool(basename(argv_orig[0]), tool, &num_readers);
+    if (!pp_tool)
+        return NULL;
+
+    if (!num_readers) {
+        /* nothing to share --> let the analyzers preprocess on their own */
+        free(pp_tool);
+        return NULL;
+    }
+
+    /* clone the argv array */
+    const size_t argv_size = (argc_orig + 1) * sizeof(char *);
+    char **argv = malloc(argv_size);
+    if (!argv) {
+        /* OOM */
+        free(pp_tool);
+        return NULL;
+    }
+    memcpy(argv, argv_orig, argv_size);
+
+    /* check whether we are going to run analyzer on a single input file */
+    const char *input = NULL;
+    const int argc_cmd = translate_args_for_analyzer(argc_orig, argv,
+            /* skips are counted by consider_running_analyzer() */ false);
+    if (0 < argc_cmd)
+        input = find_single_input(argc_cmd, argv);
+    free(argv);
+
+    char *pp_file;
+    if (!input || !(pp_file = create_pp_file(input))) {
+        free(pp_tool);
+        return NULL;
+    }
+
+    /* allocate the argv array for: TOOL -E -C [FLAGS...] INPUT -o PP_FILE */
+    char **pp_argv = malloc((argc_orig + /* see above */ 6) * sizeof(char *));
+    if (!pp_argv) {
+        /* OOM */
+        unlink(pp_file);
+        free(pp_file);
+        free(pp_tool);
+        return NULL;
+    }
+
+    int pp_argc = 0;
+    pp_argv[pp_argc++] = argv_orig[0];
+    pp_argv[pp_argc++] = "-E";
+
+    /* keep comments for -Wimplicit-fallthrough and the like */
+    pp_argv[pp_argc++] = "-C";
+
+    int i;
+    for (i = 1; i < argc_orig; ++i) {
+        char *arg = argv_orig[i];
+        if (!is_pp_flag(arg))
+            continue;
+
+        pp_argv[pp_argc++] = arg;
+        if (is_bare_pp_flag(arg) && (i + 1 < argc_orig))
+            /* bare -D, -I, ... --> we need to take the next arg, too */
+            pp_argv[pp_argc++] = argv_orig[++i];
+    }
+
+    pp_argv[pp_argc++] = (char *) input;
+    pp_argv[pp_argc++] = "-o";
+    pp_argv[pp_argc++] = pp_file;
+    pp_argv[pp_argc] = NULL;
+
+    /* the write end is closed once the preprocessor has finished */
+    int fds[2];
+    char *fd_str = NULL;
+    if (pipe2(fds, O_CLOEXEC)) {
+        unlink(pp_file);
+        free(pp_file);
+        free(pp_argv);
+        free(pp_tool);
+        return NULL;
+    }
+
+    /* the read end is inherited by the wrappers chained after this one */
+    fcntl(fds[0], F_SETFD, 0);
+
+    /* run the preprocessor in background, bypass the chained wrappers */
+    pid_preprocessor = launch_tool(pp_tool, pp_argv,
+            profile->compiler_del_args, /* quiet */ true, /* fd_out */ -1,
+            /* fd_err */ -1, /* own_group */ false);
+    free(pp_argv);
+
+    if (pid_preprocessor <= 0
+            || asprintf(&fd_str, "%d", fds[0]) < 0
+            || setenv(pp_input_envvar_name, input, /* overwrite */ 1)
+            || setenv(pp_file_envvar_name, pp_file, /* overwrite */ 1)
+            || setenv(pp_tool_envvar_name, pp_tool, /* overwrite */ 1)
+            || setenv(pp_ready_envvar_name, fd_str, /* overwrite */ 1))
+    {
+        if (0 < pid_preprocessor) {
+            kill(pid_preprocessor, SIGTERM);
+            waitpid(pid_preprocessor, NULL, 0);
+            pid_preprocessor = 0;
+        }
+
+        unsetenv(pp_file_envvar_name);
+        unsetenv(pp_tool_envvar_name);
+        unsetenv(pp_ready_envvar_name);
+        close(fds[0]);
+        close(fds[1]);
+        unlink(pp_file);
+        free(pp_file);
+        free(pp_tool);
+        free(fd_str);
+        return NULL;
+    }
+
+    free(pp_tool);
+    free(fd_str);
+    fd_pp_ready = fds[1];
+    return pp_file;
+}
+
+/* wait for the preprocessor and let the chained wrappers know it finished */
+static void finish_preprocessing(char **ppp_file)
+{
+    if (!*ppp_file)
+        return;
+
+    int status = EXIT_FAILURE;
+    siginfo_t si;
+    si.si_pid = 0;
+    while (-1 == waitid(P_PID, pid_preprocessor, &si, WEXITED))
+        if (EINTR != errno)
+            break;
+
+    if (pid_preprocessor == si.si_pid) {
+        status = exit_status(&si);
+        stats_child_reaped(/* analyzer */ false, status);
+    }
+
+    pid_preprocessor = 0;
+
+    if (status) {
+        /* preprocessing failed --> let analyzers preprocess on their own */
+        unlink(*ppp_file);
+        free(*ppp_file);
+        *ppp_file = NULL;
+    }
+
+    /* the chained wrappers have inherited the read end already */
+    const char *fd_str = getenv(pp_ready_envvar_name);
+    if (fd_str)
+        close(atoi(fd_str));
+    unsetenv(pp_ready_envvar_name);
+
+    close(fd_pp_ready);
+    fd_pp_ready = -1;
+}
+
+/* wait till the wrapper earlier in the chain finishes the preprocessed file */
+static void wait_for_pp_file(void)
+{
+    const char *fd_str = getenv(pp_ready_envvar_name);
+    if (!fd_str)
+        return;
+
+    /* make sure the file descriptor is still the pipe we have inherited */
+    const int fd = atoi(fd_str);
+    struct stat st;
+    if (0 < fd && !fstat(fd, &st) && S_ISFIFO(st.st_mode)) {
+        char c;
+        while (0 != read(fd, &c, sizeof c))
+            if (EINTR != errno)
+                break;
+
+        close(fd);
+    }
+
+    unsetenv(pp_ready_envvar_name);
+}
+
+/* feed analyzer with the preprocessed input file if available */
+static int use_preprocessed_input(int argc, char **argv)
+{
+    const char *pp_input = getenv(pp_input_envvar_name);
+    const char *pp_file = getenv(pp_file_envvar_name);
+    if (!pp_input || !pp_file)
+        /* no preprocessed input available */
+        return argc;
+
+    const char *input = find_single_input(argc, argv);
+    if (!input || !STREQ(input, pp_input))
+        /* preprocessed input does not match the current command line */
+        return argc;
+
+    /* the file name is exported before the preprocessor finishes */
+    wait_for_pp_file();
+    if (access(pp_file, R_OK))
+        /* preprocessing failed */
+        return argc;
+
+    int i;
+    for (i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (is_bare_def_inc(arg) && (i + 1 < argc)) {
+            /* -D and -I flags are already applied in the preprocessed file */
+            drop_arg(&argc, argv, i);
+            drop_arg(&argc, argv, i--);
+            continue;
+        }
+
+        if (is_def_inc(arg) || MATCH_PREFIX(arg, "--include=")) {
+            drop_arg(&argc, argv, i--);
+            continue;
+        }
+
+        if (STREQ(arg, input))
+            /* replace the input file by its preprocessed image */
+            argv[i] = (char *) pp_file;
+    }
+
+    return argc;
+}
+
+static int num_custom_opts(const char *str)
+{
+    if (!str || !str[0])
+        return 0;
+
+    int num;
+    for (num = 1; NULL != (str = strchr(str, ':')); ++num)
+        ++str;
+
+    return num;
+}
+
+static bool read_custom_opts(char **dst, const char *str)
+{
+    if (!str || !str[0])
+        return true;
+
+    /* go through all options separated by ':' */
+    for (;;) {
+        const char *term = strchr(str, ':');
+        if (!term)
+            /* this was the last option */
+            return (*dst = strdup(str));
+
+        /* allocate memory for the option in the dst array */
+        const size_t len = term - str;
+        *dst = malloc(len + /* for NUL */ 1);
+        if (!*dst)
+            return /* OOM */ false;
+
+        /* copy single option to the dst array */
+        memcpy(*dst, str, len);
+        (*dst)[len] = '\0';
+
+        /* move the cursor and jump to the next option */
+        ++dst;
+        str = term + 1;
+    }
+}
+
+static void write_job_str(FILE *fp, const char *str)
+{
+    fputs(str, fp);
+    fputc('\0', fp);
+}
+
+/* the job of the expensive tier written but not yet visible to batch runs */
+static char *deferred_job;
+
+/*
+ * Queue the expensive tier of analysis in queue_dir.  The job file contains
+ * the working directory, the analyzer, and its args, all NUL-terminated.
+ * The job is made visible to batch runs by publish_deep_analysis() once the
+ * compiler has finished.
+ */
+static void queue_deep_analysis(
+        const char                 *queue_dir,
+        const char                 *analyzer,
+        const int                   argc_cmd,
+        char **const                argv,
+        const char                 *var_add_opts)
+{
+    char *cwd = get_current_dir_name();
+    if (!cwd) {
+        fail("get_current_dir_name() failed (%s)", strerror(errno));
+        return;
+    }
+
+    /* write to a temporary file first so that batch runs see complete jobs */
+    char *tmp_name;
+    if (asprintf(&tmp_name, "%s/%s-XXXXXX.tmp", queue_dir,
+                profile->wrapper_name) < 0)
+    {
+        free(cwd);
+        return;
+    }
+
+    FILE *fp = NULL;
+    const int fd = mkstemps(tmp_name, /* .tmp */ 4);
+    if (fd < 0 || !(fp = fdopen(fd, "w"))) {
+        fail("failed to create '%s' (%s)", tmp_name, strerror(errno));
+        if (0 <= fd) {
+            close(fd);
+            unlink(tmp_name);
+        }
+        free(tmp_name);
+        free(cwd);
+        return;
+    }
+
+    write_job_str(fp, cwd);
+    write_job_str(fp, analyzer);
+    free(cwd);
+
+    int i;
+    for (i = 1; i < argc_cmd; ++i)
+        write_job_str(fp, argv[i]);
+
+    for (i = 0; profile->analyzer_def_argv[i]; ++i)
+        write_job_str(fp, profile->analyzer_def_argv[i]);
+
+    for (i = 0; profile->analyzer_deep_argv[i]; ++i)
+        write_job_str(fp, profile->analyzer_deep_argv[i]);
+
+    if (var_add_opts && var_add_opts[0]) {
+        /* custom analyzer args are separated by ':' */
+        const char *str;
+        for (str = var_add_opts; *str; ++str)
+            fputc((':' == *str) ? '\0' : *str, fp);
+        fputc('\0', fp);
+    }
+
+    if (fclose(fp)) {
+        fail("failed to write '%s' (%s)", tmp_name, strerror(errno));
+        unlink(tmp_name);
+        free(tmp_name);
+        return;
+    }
+
+    deferred_job = tmp_name;
+}
+
+/* queue the job written by queue_deep_analysis() if compilation succeeded */
+static void publish_deep_analysis(const bool compiled)
+{
+    char *tmp_name = deferred_job;
+    if (!tmp_name)
+        return;
+
+    deferred_job = NULL;
+    if (!compiled) {
+        /* compilation failed --> there is nothing to analyze */
+        unlink(tmp_name);
+        free(tmp_name);
+        return;
+    }
+
+    /* rename *.tmp to *.job to make the job visible to batch runs */
+    char *job_name = strdup(tmp_name);
+    if (job_name)
+        strcpy(job_name + strlen(job_name) - /* tmp */ 3, "job");
+    if (!job_name || rename(tmp_name, job_name)) {
+        fail("failed to queue '%s' (%s)", tmp_name, strerror(errno));
+        unlink(tmp_name);
+    }
+    else
+        stats_add(STATS_ANALYZERS_QUEUED, 1);
+
+    free(job_name);
+
+    free(tmp_name);
+}
+
+static void consider_running_analyzer(
+        const int                   argc_orig,
+        char **const                argv_orig)
+{
+    /* clone the argv array */
+    size_t argv_size = (argc_orig + 1) * sizeof(char *);
+    char **argv = malloc(argv_size);
+    if (!argv)
+        /* OOM */
+        return;
+    memcpy(argv, argv_orig, argv_size);
+
+    /* translate cmd-line args for analyzer */
+    int argc_cmd = translate_args_for_analyzer(argc_orig, argv,
+            /* count_skips */ true);
+    if (argc_cmd <= 0) {
+        /* do not start analyzer */
+        free(argv);
+        return;
+    }
+
+    /* count custom analyzer args (read from env var) */
+    const char *var_add_opts = getenv(profile->wrapper_addopts_envvar_name);
+    const int argc_custom = num_custom_opts(var_add_opts);
+
+    const char *analyzer_name_actual = analyzer_of(profile);
+
+    /* queue the expensive tier of analysis if asked to do so */
+    const char *var_defer_dir = getenv(profile->wrapper_defer_envvar_name);
+    const bool tiered = var_defer_dir && var_defer_dir[0]
+        && (1 < profile->analyzer_deep_argc);
+    if (tiered)
+        queue_deep_analysis(var_defer_dir, analyzer_name_actual,
+                argc_cmd, argv, var_add_opts);
+
+    const char *var_db_dir = (profile->analyzer_db_envvar_name)
+        ? getenv(profile->analyzer_db_envvar_name)
+        : NULL;
+
+    if (var_db_dir && var_db_dir[0])
+        /* the info for the database needs to refer to the original file */
+        db_dir = var_db_dir;
+    else if (reads_pp_input(profile, getenv("PATH"),
+                getenv(pp_tool_envvar_name)))
+        /* use the input file preprocessed earlier in the chain (if any) */
+        argc_cmd = use_preprocessed_input(argc_cmd, argv);
+
+    /* capture info for the cross-function database (single input only) */
+    int fd_out = -1;
+    const char *input = (db_dir)
+        ? find_single_input(argc_cmd, argv)
+        : NULL;
+
+    /* the database refers to the input file by path that is unique per TU */
+    if (input && (db_input = canonicalize_file_name(input))) {
+        int i;
+        for (i = 1; i < argc_cmd; ++i)
+            if (argv[i] == input)
+                argv[i] = db_input;
+
+        fd_out = db_create_output(db_dir, &db_out_file);
+    }
+
+    /* use the cross-function database if it exists already */
+    char *db_arg = (db_dir)
+        ? db_analyzer_arg(db_dir)
+        : NULL;
+
+    const int argc_db = (0 <= fd_out) + !!db_arg;
+
+    /* in the tiered mode, run only the cheap tier of analysis in background */
+    const int argc_fast = (tiered)
+        ? profile->analyzer_fast_argc - /* terminating NULL */1
+        : 0;
+
+    const int argc_total = argc_cmd + profile->analyzer_def_argc + argc_fast
+        + argc_db + argc_custom;
+    if (argc_orig < argc_total) {
+        /* enlarge the argv array */
+        argv_size = (argc_total + 1) * sizeof(char *);
+        char **argv_new = realloc(argv, argv_size);
+        if (!argv_new) {
+            /* OOM */
+            free(argv);
+            return;
+        }
+        argv = argv_new;
+    }
+
+    /* append default analyzer args */
+    char **argv_now = argv + argc_cmd;
+    memcpy(argv_now, profile->analyzer_def_argv,
+            profile->analyzer_def_argc * sizeof(char *));
+    argv_now += profile->analyzer_def_argc - /* terminating NULL */1;
+
+    /* append analyzer args of the cheap tier (if any) */
+    memcpy(argv_now, profile->analyzer_fast_argv, argc_fast * sizeof(char *));
+    argv_now += argc_fast;
+
+    /* append args of the cross-function database (if any) */
+    if (0 <= fd_out)
+        *argv_now++ = "--info";
+    if (db_arg)
+        *argv_now++ = db_arg;
+
+    /* append custom analyzer args (read from env var) if any */
+    if (!read_custom_opts(argv_now, var_add_opts)) {
+        free(argv);
+        return;
+    }
+
+    /* make sure that the analyzer process is named analyzer_name_actual */
+    argv[0] = (char *) analyzer_name_actual;
+
+    /* make sure there is NULL at the end of argv[] */
+    argv[argc_total - 1] = NULL;
+
+    const char *var_debug = getenv(profile->wrapper_debug_envvar_name);
+    if (var_debug && *var_debug) {
+        /* run-time debugging enabled */
         const pid_t pid = getpid();
 
         int i;
         for(i = 0; i < argc_total; ++i)
-            printf("%s[%d]: argv[%d] = %s\n", wrapper_name, pid, i, argv[i]);
+            printf("%s[%d]: argv[%d] = %s\n", profile->wrapper_name,
+                    pid, i, argv[i]);
     }
 
+    /* pass output of the analyzer through pipes if statistics are enabled */
+    int fd_pipe_out = fd_out;
+    int fd_pipe_err = -1;
+    create_diag_pipes(&fd_pipe_out, &fd_pipe_err);
+
     /* try to start analyzer */
-    pid_analyzer = launch_tool(analyzer_name_actual, argv, /* del_args */ NULL);
+    /* skip the search of $PATH if the analyzer was resolved in advance */
+    const char *analyzer_file = (analyzer_resolved)
+        ? analyzer_resolved
+        : analyzer_name_actual;
+    pid_analyzer = launch_tool(analyzer_file, argv, /* del_args */ NULL,
+            /* quiet */ false, fd_pipe_out, fd_pipe_err, /* own_group */ true);
+    if (0 < pid_analyzer)
+        stats_analyzer_started();
+
+    if (fd_pipe_out != fd_out)
+        close(fd_pipe_out);
+    if (0 <= fd_pipe_err)
+        close(fd_pipe_err);
+
+    if (0 <= fd_out) {
+        close(fd_out);
+        if (pid_analyzer <= 0) {
+            /* nothing to be captured */
+            unlink(db_out_file);
+            free(db_out_file);
+            db_out_file = NULL;
+        }
+    }
+
+    free(db_arg);
 
     /* FIXME: release also the memory allocated by asprintf() and
        read_custom_opts() */
     free(argv);
 }
 
+/* return start time of the process (to detect reuse of PIDs), 0 on error */
+static unsigned long long proc_start_time(const pid_t pid)
+{
+    char *file_name;
+    if (asprintf(&file_name, "/proc/%d/stat", pid) < 0)
+        return 0ULL;
+
+    FILE *fp = fopen(file_name, "r");
+    free(file_name);
+    if (!fp)
+        return 0ULL;
+
+    char buf[1024];
+    const size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+
+    /* skip pid and comm, which may contain spaces and parentheses */
+    const char *str = strrchr(buf, ')');
+    if (!str)
+        return 0ULL;
+
+    /* starttime is the 22nd field, i.e. the 20th field after comm */
+    unsigned long long start_time = 0ULL;
+    int field;
+    for (field = 2; str && field < 22; ++field)
+        if ((str = strchr(str + 1, ' ')) && (field == 21))
+            start_time = strtoull(str + 1, NULL, 10);
+
+    return start_time;
+}
+
+/*
+ * Return path to the per-user directory, $XDG_RUNTIME_DIR/cscppc by default,
+ * NULL on error.  The error is reported unless what is NULL.
+ */
+static char *user_run_dir(const char *what)
+{
+    char *dir;
+    const char *run_dir = getenv("XDG_RUNTIME_DIR");
+    if ((run_dir && run_dir[0])
+            ? (asprintf(&dir, "%s/cscppc", run_dir) < 0)
+            : (asprintf(&dir, "/tmp/cscppc-%u", getuid()) < 0))
+        return NULL;
+
+    /* make sure that nobody else can tamper with our files */
+    struct stat st;
+    if ((mkdir(dir, 0700) && (EEXIST != errno))
+            || lstat(dir, &st)
+            || !S_ISDIR(st.st_mode)
+            || (st.st_uid != getuid()))
+    {
+        if (what)
+            fail("unusable %s '%s'", what, dir);
+
+        free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+/* return path to a registry entry identifying the TU, NULL on error */
+static char *registry_entry(const int argc, char **argv)
+{
+    char *cwd = get_current_dir_name();
+    if (!cwd)
+        return NULL;
+
+    /* the TU is identified by working directory, input and output files */
+    unsigned long long hash = hash_str(HASH_INIT, cwd);
+    free(cwd);
+
+    int i;
+    for (i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (STREQ(arg, "-o") && (i + 1 < argc))
+            hash = hash_str(hash, argv[++i]);
+        else if (MATCH_PREFIX(arg, "-o"))
+            hash = hash_str(hash, arg + /* -o */ 2);
+        else if (is_bare_def_inc(arg))
+            ++i;
+        else if (is_input_file(arg, profile->analyzer_is_cxx_ready))
+            hash = hash_str(hash, arg);
+    }
+
+    char *dir = user_run_dir("registry of analyses");
+    if (!dir)
+        return NULL;
+
+    char *entry;
+    if (asprintf(&entry, "%s/%s-%016llx", dir, profile->wrapper_name, hash) < 0)
+        entry = NULL;
+
+    free(dir);
+    return entry;
+}
+
+/* open and lock the registry entry, return its fd, or -1 on error */
+static int lock_registry_entry(const char *entry)
+{
+    for (;;) {
+        const int fd = open(entry, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC,
+                0600);
+        if (fd < 0)
+            return -1;
+
+        while (flock(fd, LOCK_EX))
+            if (EINTR != errno) {
+                close(fd);
+                return -1;
+            }
+
+        struct stat st_fd, st_entry;
+        if (!fstat(fd, &st_fd) && !stat(entry, &st_entry)
+                && (st_fd.st_dev == st_entry.st_dev)
+                && (st_fd.st_ino == st_entry.st_ino))
+            return fd;
+
+        /* the entry was removed while we were waiting for the lock */
+        close(fd);
+    }
+}
+
+/* read PID of the analyzer registered in the entry, 0 if none */
+static pid_t read_registry_entry(const int fd, unsigned long long *pstart)
+{
+    char buf[64];
+    const ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0)
+        return 0;
+
+    buf[len] = '\0';
+    int pid;
+    if (2 != sscanf(buf, "%d %llu", &pid, pstart))
+        return 0;
+
+    return pid;
+}
+
+/*
+ * Register the analyzer just started for the TU being compiled and terminate
+ * the analyzer previously registered for the same TU (if any).  Returns path
+ * to the registry entry, or NULL if superseding is not enabled.
+ */
+static char *supersede_analysis(const int argc, char **argv)
+{
+    const char *var_supersede = getenv(supersede_envvar_name);
+    if (!var_supersede || !var_supersede[0])
+        /* superseding of analyses not enabled */
+        return NULL;
+
+    char *entry = registry_entry(argc, argv);
+    if (!entry)
+        return NULL;
+
+    const int fd = lock_registry_entry(entry);
+    if (fd < 0) {
+        fail("failed to lock '%s' (%s)", entry, strerror(errno));
+        free(entry);
+        return NULL;
+    }
+
+    unsigned long long start_time;
+    const pid_t pid = read_registry_entry(fd, &start_time);
+    if (0 < pid && start_time == proc_start_time(pid))
+        /* the TU is being recompiled --> kill the stale analyzer now! */
+        kill(-pid, SIGTERM);
+
+    /* register our analyzer in place of the stale one */
+    if (ftruncate(fd, 0) || (dprintf(fd, "%d %llu\n", pid_analyzer,
+                    proc_start_time(pid_analyzer)) < 0))
+        fail("failed to write '%s' (%s)", entry, strerror(errno));
+
+    /* release the lock */
+    close(fd);
+    return entry;
+}
+
+/* remove the registry entry unless it has been taken over meanwhile */
+static void unregister_analysis(const char *entry, const pid_t pid)
+{
+    const int fd = lock_registry_entry(entry);
+    if (fd < 0)
+        return;
+
+    unsigned long long start_time;
+    if (pid == read_registry_entry(fd, &start_time))
+        unlink(entry);
+
+    close(fd);
+}
+
+/* return key of the info about input stored in the cross-function database */
+static char *db_info_key(const char *input)
+{
+    /* the TU is identified by the absolute path of the input file */
+    const unsigned long long hash = hash_str(HASH_INIT, input);
+
+    char *key;
+    if (asprintf(&key, "%016llx", hash) < 0)
+        return NULL;
+
+    return key;
+}
+
 static int run_compiler_and_analyzer(
         const char                 *tool,
         const int                   argc,
@@ -452,23 +1844,74 @@ static int run_compiler_and_analyzer(
     if (!install_signal_forwarder())
         return fail("unable to install signal forwarder");
 
-    pid_compiler = launch_tool(tool, argv, compiler_del_args);
-    if (pid_compiler <= 0)
-        return EXIT_FAILURE;
+    /* preprocess the input file only once if asked to do so */
+    char *pp_file = start_preprocessing(tool, argc, argv);
+
+    pid_compiler = launch_tool(tool, argv, profile->compiler_del_args,
+            /* quiet */ false, /* fd_out */ -1, /* fd_err */ -1,
+            /* own_group */ false);
+
+    /* the compiler runs in parallel with the preprocessor */
+    finish_preprocessing(&pp_file);
+
+    int status;
+    if (pid_compiler <= 0) {
+        status = EXIT_FAILURE;
+        goto cleanup;
+    }
 
     consider_running_analyzer(argc, argv);
 
-    tag_process_name(wrapper_proc_prefix, argc, argv);
+    /* take over the analysis of the same TU if asked to do so */
+    const pid_t pid = pid_analyzer;
+    char *entry = NULL;
+    if (0 < pid)
+        entry = supersede_analysis(argc, argv);
 
-    const int status = wait_for(pid_compiler);
+    tag_process_name(profile->wrapper_proc_prefix, argc, argv);
 
-    if (0 < pid_analyzer) {
-        if (status)
-            /* compilation failed --> kill analyzer now! */
-            kill(pid_analyzer, SIGTERM);
+    status = wait_for(pid_compiler);
 
+    /* queue the expensive tier of analysis only for successful compilation */
+    publish_deep_analysis(!status);
+
+    if (status && 0 < pid_analyzer)
+        /* compilation failed --> kill analyzer (and its children) now! */
+        kill(-pid_analyzer, SIGTERM);
+
+    /* pass output of the analyzer through (if relayed via pipes) */
+    relay_diagnostics();
+
+    if (0 < pid_analyzer)
         /* analyzer was started, wait till it finishes */
         wait_for(pid_analyzer);
+
+    if (db_out_file) {
+        /* store info for the cross-function database unless killed */
+        char *key = db_info_key(db_input);
+        if (key)
+            db_store_info(db_dir, db_out_file, key, db_input,
+                    /* complete */ (status_analyzer < 0x80));
+        else
+            unlink(db_out_file);
+
+        free(key);
+        free(db_out_file);
+        db_out_file = NULL;
+    }
+
+    free(db_input);
+
+    if (entry) {
+        unregister_analysis(entry, pid);
+        free(entry);
+    }
+
+cleanup:
+    if (pp_file) {
+        /* all analyzers in the chain have finished --> remove the file */
+        unlink(pp_file);
+        free(pp_file);
     }
 
     return status;
@@ -478,7 +1921,7 @@ static bool sanitize_path(const char *tool, const char *arg0)
 {
     /* remove self from $PATH in order to avoid infinite recursion */
     char *path = getenv("PATH");
-    if (remove_self_from_path(tool, path, wrapper_name) && path[0])
+    if (remove_self_from_path(tool, path, self_name) && path[0])
         return true;
 
     /* symlink not found in $PATH ... are we invoked by its absolute path? */
@@ -495,18 +1938,517 @@ static bool sanitize_path(const char *tool, const char *arg0)
 
     /* we are being invoked in an unsupported way */
     fail("symlink '%s -> %s' not found in $PATH (%s)",
-            tool, wrapper_name, path);
+            tool, profile->wrapper_name, path);
+    return false;
+}
+
+/* fingerprint of the file to detect changes since it was resolved */
+static char *file_fingerprint(const char *file)
+{
+    struct stat st;
+    if (stat(file, &st))
+        return NULL;
+
+    char *fp;
+    if (asprintf(&fp, "%llu:%llu:%lld.%09ld",
+                (unsigned long long) st.st_dev,
+                (unsigned long long) st.st_ino,
+                (long long) st.st_mtim.tv_sec,
+                st.st_mtim.tv_nsec) < 0)
+        return NULL;
+
+    return fp;
+}
+
+/* find an executable named tool in $PATH the same way as execvp() does */
+static char *find_in_path(const char *tool, const char *path)
+{
+    for (;;) {
+        const char *term = strchr(path, ':');
+        const int len = (term) ? (int) (term - path) : (int) strlen(path);
+
+        /* an empty item in $PATH stands for the current directory */
+        char *file;
+        if (0 < asprintf(&file, "%.*s/%s", len, (len) ? path : ".", tool)) {
+            struct stat st;
+            if (!access(file, X_OK) && !stat(file, &st) && S_ISREG(st.st_mode))
+                return file;
+
+            free(file);
+        }
+
+        if (!term)
+            return NULL;
+
+        path = term + 1;
+    }
+}
+
+/* return profile of the given name, NULL if there is no such profile */
+static const struct wrapper_profile *find_profile(const char *name)
+{
+    const struct wrapper_profile *p;
+    for (p = wrapper_profiles; p->wrapper_name; ++p)
+        if (STREQ(p->wrapper_name, name))
+            return p;
+
+    return NULL;
+}
+
+/* return name of our wrapper the file points to, NULL if it is not one */
+static const char *wrapper_of(const char *file)
+{
+    char *target = canonicalize_file_name(file);
+    if (!target)
+        return NULL;
+
+    const char *base = strrchr(target, '/');
+    base = (base) ? base + 1 : target;
+
+    const struct wrapper_profile *wrap = find_profile(base);
+    free(target);
+    return (wrap) ? wrap->wrapper_name : NULL;
+}
+
+/* return copy of $PATH without the directories where tool points to wrap */
+static char *path_without_wrapper(
+        const char                 *path,
+        const char                 *tool,
+        const char                 *wrap)
+{
+    char *result = malloc(strlen(path) + /* for NUL */ 1);
+    if (!result)
+        return NULL;
+
+    char *dst = result;
+    for (;;) {
+        const char *term = strchr(path, ':');
+        const int len = (term) ? (int) (term - path) : (int) strlen(path);
+
+        char *file;
+        bool keep = true;
+        if (0 < asprintf(&file, "%.*s/%s", len, (len) ? path : ".", tool)) {
+            const char *wrap_now = wrapper_of(file);
+            keep = !wrap_now || !STREQ(wrap_now, wrap);
+            free(file);
+        }
+
+        if (keep) {
+            if (dst != result)
+                *dst++ = ':';
+            memcpy(dst, path, len);
+            dst += len;
+        }
+
+        if (!term)
+            break;
+
+        path = term + 1;
+    }
+
+    *dst = '\0';
+    return result;
+}
+
+/*
+ * Append a record about the hop of wrap to *precords.  The record consists of
+ * tab-separated fields: wrapper, tool, hash of the incoming $PATH, sanitized
+ * $PATH, resolved compiler, fingerprint of the compiler, name of the analyzer,
+ * the analyzer resolved in the sanitized $PATH, and its fingerprint.  The last
+ * two fields are empty if the analyzer has not been resolved.
+ */
+static bool add_resolved_record(
+        char                      **precords,
+        const char                 *wrap,
+        const char                 *tool,
+        const char                 *path_in,
+        const char                 *path_next,
+        const char                 *file)
+{
+    char *fp = (file && file[0] == '/')
+        ? file_fingerprint(file)
+        : NULL;
+    if (!fp)
+        return false;
+
+    const struct wrapper_profile *p = find_profile(wrap);
+    const char *analyzer = (p) ? analyzer_of(p) : "";
+    if (strpbrk(analyzer, "\t\n"))
+        /* not representable in the record */
+        analyzer = "";
+
+    /* look up the analyzer in the sanitized $PATH as execvp() would do */
+    char *analyzer_file = NULL;
+    char *analyzer_fp = NULL;
+    if (analyzer[0] && !strchr(analyzer, '/')
+            && (analyzer_file = find_in_path(analyzer, path_next))
+            && (analyzer_file[0] == '/'))
+        analyzer_fp = file_fingerprint(analyzer_file);
+
+    if (!analyzer_fp) {
+        free(analyzer_file);
+        analyzer_file = NULL;
+    }
+
+    char *records;
+    const bool ok = (0 <= asprintf(&records,
+                "%s%s\t%s\t%016llx\t%s\t%s\t%s\t%s\t%s\t%s\n",
+                (*precords) ? *precords : "", wrap, tool,
+                hash_str(HASH_INIT, path_in), path_next, file, fp, analyzer,
+                (analyzer_file) ? analyzer_file : "",
+                (analyzer_fp) ? analyzer_fp : ""));
+
+    free(analyzer_fp);
+    free(analyzer_file);
+    free(fp);
+    if (!ok)
+        return false;
+
+    free(*precords);
+    *precords = records;
+    return true;
+}
+
+/* return hash of identity and mtime of the directories in $PATH, 0 if none */
+static unsigned long long path_dirs_hash(const char *path)
+{
+    unsigned long long hash = HASH_INIT;
+    for (;;) {
+        const char *term = strchr(path, ':');
+        const int len = (term) ? (int) (term - path) : (int) strlen(path);
+        if (!len || path[0] != '/')
+            /* the lookup depends on the current working directory */
+            return 0ULL;
+
+        char *dir = strndup(path, len);
+        if (!dir)
+            return 0ULL;
+
+        /* the mtime of a directory changes once an entry is added/removed */
+        char buf[PATH_MAX + 64];
+        struct stat st;
+        if (stat(dir, &st))
+            snprintf(buf, sizeof buf, "%s:-", dir);
+        else
+            snprintf(buf, sizeof buf, "%s:%llu:%llu:%lld.%09ld", dir,
+                    (unsigned long long) st.st_dev,
+                    (unsigned long long) st.st_ino,
+                    (long long) st.st_mtim.tv_sec,
+                    st.st_mtim.tv_nsec);
+
+        free(dir);
+        hash = hash_str(hash, buf);
+        if (!term)
+            return hash;
+
+        path = term + 1;
+    }
+}
+
+/* return path to the file caching the resolution of tool for $PATH */
+static char *resolved_cache_file(const char *tool, const char *path)
+{
+    char *dir = user_run_dir(/* quiet */ NULL);
+    if (!dir)
+        return NULL;
+
+    unsigned long long hash = hash_str(HASH_INIT, profile->wrapper_name);
+    hash = hash_str(hash, tool);
+    hash = hash_str(hash, path);
+
+    char *file;
+    if (asprintf(&file, "%s/resolved-%016llx", dir, hash) < 0)
+        file = NULL;
+
+    free(dir);
+    return file;
+}
+
+/*
+ * Store the records about the chain of wrappers resolved for $PATH so that
+ * subsequent invocations of the wrapper do not need to resolve it again.  The
+ * first line holds path_dirs_hash() of $PATH to validate the records.
+ */
+static void store_resolved_cache(
+        const char                 *tool,
+        const char                 *path,
+        const char                 *records)
+{
+    const unsigned long long dirs_hash = path_dirs_hash(path);
+    if (!dirs_hash)
+        return;
+
+    char *file = resolved_cache_file(tool, path);
+    char *tmp_file;
+    if (!file || asprintf(&tmp_file, "%s-XXXXXX", file) < 0) {
+        free(file);
+        return;
+    }
+
+    const int fd = mkostemp(tmp_file, O_CLOEXEC);
+    FILE *fp = (0 <= fd) ? fdopen(fd, "w") : NULL;
+    if (fp) {
+        /* replace the cache file at once */
+        const bool ok = (0 <= fprintf(fp, "%016llx\n%s", dirs_hash, records));
+        if (fclose(fp) || !ok || rename(tmp_file, file))
+            unlink(tmp_file);
+    }
+    else if (0 <= fd) {
+        close(fd);
+        unlink(tmp_file);
+    }
+
+    free(tmp_file);
+    free(file);
+}
+
+/* export the records cached by store_resolved_cache() if still valid */
+static bool load_resolved_cache(const char *tool, const char *path)
+{
+    char *file = resolved_cache_file(tool, path);
+    if (!file)
+        return false;
+
+    const int fd = open(file, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    free(file);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    char *buf = NULL;
+    ssize_t len = -1;
+    if (!fstat(fd, &st) && (st.st_uid == getuid()) && (0 < st.st_size)
+            && (buf = malloc(st.st_size + /* for NUL */ 1)))
+        len = read(fd, buf, st.st_size);
+
+    close(fd);
+    if (len <= 0 || len != st.st_size) {
+        free(buf);
+        return false;
+    }
+
+    buf[len] = '\0';
+
+    /* make sure that no directory in $PATH has changed meanwhile */
+    char hash[/* 16 hex digits and NUL */ 17];
+    snprintf(hash, sizeof hash, "%016llx", path_dirs_hash(path));
+    const char *records = strchr(buf, '\n');
+    const bool valid = records
+        && (records - buf == /* see above */ 16)
+        && !strncmp(buf, hash, 16)
+        && !setenv(resolved_envvar_name, records + 1, /* overwrite */ 1);
+
+    free(buf);
+    return valid;
+}
+
+/*
+ * Resolve the compiler in the sanitized $PATH.  If it is another wrapper of
+ * ours, follow the chain of wrappers up to the real compiler and export the
+ * result of each hop, including this one, so that the chained wrappers do not
+ * need to sanitize $PATH and search it again (see add_resolved_record()).
+ * The records are also cached for subsequent invocations of this wrapper with
+ * the same incoming $PATH, which is given by path_in.
+ */
+static char *resolve_compiler_chain(const char *tool, const char *path_in)
+{
+    const char *path = getenv("PATH");
+    if (!path)
+        return NULL;
+
+    char *resolved = find_in_path(tool, path);
+    if (!resolved || resolved[0] != '/')
+        /* let execvp() search $PATH and report errors */
+        return resolved;
+
+    char *records = NULL;
+    if (!path_in || !add_resolved_record(&records, profile->wrapper_name,
+                tool, path_in, path, resolved))
+    {
+        free(records);
+        return resolved;
+    }
+
+    char *path_now = strdup(path);
+    const char *file = resolved;
+    const char *wrap;
+    while (path_now && (wrap = wrapper_of(file))) {
+        /* the next hop is a wrapper --> do what it is going to do */
+        char *path_next = path_without_wrapper(path_now, tool, wrap);
+        if (!path_next)
+            break;
+
+        char *file_next = find_in_path(tool, path_next);
+        if (!add_resolved_record(&records, wrap, tool, path_now, path_next,
+                    file_next))
+        {
+            free(file_next);
+            free(path_next);
+            break;
+        }
+
+        if (file != resolved)
+            free((char *) file);
+        file = file_next;
+
+        free(path_now);
+        path_now = path_next;
+    }
+
+    if (file != resolved)
+        free((char *) file);
+    free(path_now);
+
+    setenv(resolved_envvar_name, records, /* overwrite */ 1);
+    store_resolved_cache(tool, path_in, records);
+    free(records);
+    return resolved;
+}
+
+/* return true if the file has not changed since the fingerprint was taken */
+static bool matches_fingerprint(const char *file, const char *fp)
+{
+    char *fp_now = file_fingerprint(file);
+    const bool match = fp_now && STREQ(fp_now, fp);
+    free(fp_now);
+    return match;
+}
+
+/* use the compiler resolved earlier in the chain if it has not changed */
+static char *use_resolved_compiler(const char *tool)
+{
+    const char *records = getenv(resolved_envvar_name);
+    const char *path = getenv("PATH");
+    if (!records || !records[0] || !path)
+        return NULL;
+
+    char *hash;
+    if (asprintf(&hash, "%016llx",
+                hash_str(HASH_INIT, path)) < 0)
+        return NULL;
+
+    char *buf = strdup(records);
+    char *resolved = NULL;
+    char *line, *cursor = buf;
+    while (buf && !resolved && (line = strsep(&cursor, "\n"))) {
+        const char *wrap      = strsep(&line, "\t");
+        const char *tool_now  = strsep(&line, "\t");
+        const char *path_hash = strsep(&line, "\t");
+        const char *path_next = strsep(&line, "\t");
+        const char *file      = strsep(&line, "\t");
+        const char *fp        = strsep(&line, "\t");
+        const char *analyzer  = strsep(&line, "\t");
+        const char *a_file    = strsep(&line, "\t");
+        const char *a_fp      = strsep(&line, "\t");
+        if (!a_fp || !STREQ(wrap, profile->wrapper_name)
+                || !STREQ(tool_now, tool) || !STREQ(path_hash, hash))
+            continue;
+
+        /* make sure the compiler has not changed since it was resolved */
+        if (!matches_fingerprint(file, fp)
+                || setenv("PATH", path_next, /* overwrite */ 1))
+            continue;
+
+        resolved = strdup(file);
+
+        /* the analyzer would be otherwise looked up in $PATH by execvp() */
+        if (a_file[0] && STREQ(analyzer, analyzer_of(profile))
+                && matches_fingerprint(a_file, a_fp))
+            analyzer_resolved = strdup(a_file);
+    }
+
+    free(buf);
+    free(hash);
+    return resolved;
+}
+
+/* return base name of the file the executable resolves to, NULL if none */
+static char *resolve_self_name(const char *exe)
+{
+    char *target = canonicalize_file_name(exe);
+    if (!target)
+        return NULL;
+
+    const char *base = strrchr(target, '/');
+    char *name = strdup((base) ? base + 1 : target);
+    free(target);
+    return name;
+}
+
+/* return base name of the running executable as resolved by the kernel */
+static char *read_self_name(void)
+{
+    /* the link is already resolved, no need to canonicalize it again */
+    char buf[PATH_MAX];
+    const ssize_t len = readlink("/proc/self/exe", buf, sizeof buf - 1);
+    if (len <= 0)
+        return NULL;
+
+    buf[len] = '\0';
+
+    static const char deleted[] = " (deleted)";
+    const size_t len_deleted = sizeof(deleted) - 1;
+    if (len_deleted < (size_t) len && STREQ(buf + len - len_deleted, deleted))
+        /* the executable has been replaced while running */
+        return NULL;
+
+    const char *base = strrchr(buf, '/');
+    return strdup((base) ? base + 1 : buf);
+}
+
+/* select the profile by the name of the (hard) link we are executed by */
+static bool select_profile(const char *arg0)
+{
+    /* the name the kernel has resolved the executable to */
+    self_name = read_self_name();
+    if (self_name && (profile = find_profile(self_name)))
+        return true;
+
+    /* /proc is not mounted --> resolve argv[0] the same way execvp() does */
+    const char *path = getenv("PATH");
+    char *exe = (strchr(arg0, '/') || !path)
+        ? strdup(arg0)
+        : find_in_path(arg0, path);
+    char *name = (exe) ? resolve_self_name(exe) : NULL;
+    free(exe);
+    if (name && (profile = find_profile(name))) {
+        free(self_name);
+        self_name = name;
+        return true;
+    }
+
+    if (!self_name)
+        self_name = (name) ? name : strdup(arg0);
+    else
+        free(name);
+
+    if (!self_name)
+        return false;
+
+    /* the binary is not named after any profile --> ask the environment */
+    const char *var_profile = getenv(profile_envvar_name);
+    if (var_profile && (profile = find_profile(var_profile)))
+        return true;
+
+    fprintf(stderr, "%s: error: unknown profile, set %s to one of:",
+            self_name, profile_envvar_name);
+
+    const struct wrapper_profile *p;
+    for (p = wrapper_profiles; p->wrapper_name; ++p)
+        fprintf(stderr, " %s", p->wrapper_name);
+
+    fputc('\n', stderr);
     return false;
 }
 
 int main(int argc, char *argv[])
 {
-    if (argc < 1)
-        return fail("argc < 1");
+    if (argc < 1 || !select_profile(argv[0]))
+        return EXIT_FAILURE;
 
     /* check which tool we are asked to run via this wrapper */
     char *tool = basename(argv[0]);
-    if (STREQ(tool, wrapper_name))
+    if (STREQ(tool, profile->wrapper_name) || STREQ(tool, self_name))
         return handle_args(argc, argv);
 
     /* duplicate the string as basename() return value is not valid forever */
@@ -514,11 +2456,35 @@ int main(int argc, char *argv[])
     if (!tool)
         return fail("strdup() failed");
 
-    /* remove self from $PATH in order to avoid infinite recursion */
-    const int status = (sanitize_path(tool, argv[0]))
-        ? run_compiler_and_analyzer(tool, argc, argv)
-        : EXIT_FAILURE;
+    /* use the compiler resolved by a wrapper earlier in the chain if valid */
+    char *compiler = use_resolved_compiler(tool);
+
+    /* use the chain resolved by a previous invocation if still valid */
+    const char *path = getenv("PATH");
+    if (!compiler && path && load_resolved_cache(tool, path))
+        compiler = use_resolved_compiler(tool);
+
+    if (!compiler) {
+        /* the records are going to be resolved again if possible */
+        unsetenv(resolved_envvar_name);
+        char *path_in = (path) ? strdup(path) : NULL;
+
+        /* remove self from $PATH in order to avoid infinite recursion */
+        if (!sanitize_path(tool, argv[0])) {
+            free(path_in);
+            free(tool);
+            return EXIT_FAILURE;
+        }
+
+        compiler = resolve_compiler_chain(tool, path_in);
+        free(path_in);
+    }
+
+    const int status = run_compiler_and_analyzer((compiler) ? compiler : tool,
+            argc, argv);
 
+    free(analyzer_resolved);
+    free(compiler);
     free(tool);
     return status;
 }
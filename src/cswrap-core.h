@@ -22,33 +22,83 @@
 
 #include <stdbool.h>
 
-extern const char *wrapper_name;
+/* static configuration of the wrapper for a particular analyzer */
+struct wrapper_profile {
+    const char *wrapper_name;
 
-extern const char *wrapper_path;
+    const char *wrapper_path;
 
-extern const char *wrapper_proc_prefix;
+    const char *wrapper_proc_prefix;
 
-extern const char *wrapper_addopts_envvar_name;
+    const char *wrapper_addopts_envvar_name;
 
-extern const char *wrapper_debug_envvar_name;
+    const char *wrapper_debug_envvar_name;
 
-extern const char *analyzer_name;
+    /**
+     * The name of the environment variable which value is the path to a
+     * directory where deep analysis jobs are queued.  If the value is
+     * non-empty string, the analyzer runs in background with
+     * analyzer_fast_argv appended and the job with analyzer_deep_argv
+     * appended is queued for a post-build batch run.
+     */
+    const char *wrapper_defer_envvar_name;
 
-/**
- * The name of the environment variable which value is the path (relative or
- * absolute) to the analyzer binary. If value of the environment variable is
- * non-empty string, it's used to override the value of analyzer_name.
- */
-extern const char *analyzer_bin_envvar_name;
+    /**
+     * The name of the environment variable which value is the path to a
+     * directory where the cross-function database of the analyzer is
+     * maintained.  NULL if the analyzer does not use any such database.
+     */
+    const char *analyzer_db_envvar_name;
+
+    const char *analyzer_name;
+
+    /**
+     * The name of the environment variable which value is the path (relative
+     * or absolute) to the analyzer binary. If value of the environment
+     * variable is non-empty string, it's used to override analyzer_name.
+     */
+    const char *analyzer_bin_envvar_name;
+
+    bool analyzer_is_cxx_ready;
+
+    bool analyzer_is_gcc_compatible;
+
+    /**
+     * True if the analyzer can read the input file preprocessed once for all
+     * the wrappers in a chain, provided that the analyzer is the same binary
+     * as the compiler that preprocesses the file.  It is the case of the GCC
+     * analyzer only.  Clang and smatch predefine different macros, and
+     * cppcheck would analyze the expanded system headers, too.
+     */
+    bool analyzer_reads_pp_input;
 
-extern const bool analyzer_is_cxx_ready;
+    const char **analyzer_def_argv;
 
-extern const bool analyzer_is_gcc_compatible;
+    int analyzer_def_argc;
 
-extern const char **analyzer_def_argv;
+    const char **analyzer_fast_argv;
 
-extern const int analyzer_def_argc;
+    int analyzer_fast_argc;
+
+    /**
+     * Analyzer args of the expensive tier run after the build finishes.  If
+     * the list is empty, tiered analysis is not supported by the analyzer.
+     */
+    const char **analyzer_deep_argv;
+
+    int analyzer_deep_argc;
+
+    const char **compiler_del_args;
+};
+
+/**
+ * Table of the profiles built into the multi-call binary, terminated by an
+ * entry with wrapper_name set to NULL.  The profile is selected by the name
+ * of the (hard) link the binary is executed by.
+ */
+extern const struct wrapper_profile wrapper_profiles[];
 
-extern const char **compiler_del_args;
+/* the profile selected at startup */
+extern const struct wrapper_profile *profile;
 
 #endif /* CSWRAP_CORE_H */
@@ -0,0 +1,585 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This file is part of cscppc.
+ *
+ * cscppc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * cscppc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cscppc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "cswrap-db.h"
+#include "cswrap-core.h"
+#include "cswrap/src/cswrap-util.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* the name of the database file as expected by smatch */
+static const char *db_base_name = "smatch_db.sqlite";
+
+/* directory with the scripts of smatch that create the database */
+static const char *db_scripts_envvar_name = "CSMATCH_DB_SCRIPTS_DIR";
+static const char *db_scripts_dir_default = "/usr/share/smatch/smatch_data/db";
+
+/* print error and return EXIT_FAILURE */
+static int db_fail(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+
+    fprintf(stderr, "%s: error: ", profile->wrapper_name);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+
+    va_end(ap);
+    return EXIT_FAILURE;
+}
+
+static bool has_suffix(const char *str, const char *suffix)
+{
+    const size_t len = strlen(str);
+    const size_t len_suffix = strlen(suffix);
+    return (len_suffix < len) && STREQ(str + len - len_suffix, suffix);
+}
+
+char *db_analyzer_arg(const char *db_dir)
+{
+    char *db_file;
+    if (asprintf(&db_file, "%s/%s", db_dir, db_base_name) < 0)
+        return NULL;
+
+    char *arg = NULL;
+    if (!access(db_file, R_OK)
+            && (asprintf(&arg, "--db-file=%s", db_file) < 0))
+        arg = NULL;
+
+    free(db_file);
+    return arg;
+}
+
+/* return path to the directory with per-TU info, create it if needed */
+static char *info_dir(const char *db_dir)
+{
+    char *dir;
+    if (asprintf(&dir, "%s/info", db_dir) < 0)
+        return NULL;
+
+    if ((mkdir(db_dir, 0777) && (EEXIST != errno))
+            || (mkdir(dir, 0777) && (EEXIST != errno)))
+    {
+        db_fail("failed to create '%s' (%s)", dir, strerror(errno));
+        free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+int db_create_output(const char *db_dir, char **pname)
+{
+    char *dir = info_dir(db_dir);
+    if (!dir)
+        return -1;
+
+    const int rv = asprintf(pname, "%s/.out-XXXXXX", dir);
+    free(dir);
+    if (rv < 0)
+        return -1;
+
+    const int fd = mkostemp(*pname, O_CLOEXEC);
+    if (fd < 0) {
+        db_fail("failed to create '%s' (%s)", *pname, strerror(errno));
+        free(*pname);
+        *pname = NULL;
+    }
+
+    return fd;
+}
+
+/* return true if the line was printed by smatch because of --info */
+static bool is_info_line(const char *line)
+{
+    if (strstr(line, " info: "))
+        return true;
+
+    /* SQL: ..., SQL_caller_info: ..., and the like */
+    const char *str = strstr(line, " SQL");
+    if (!str)
+        return false;
+
+    str += /* " SQL" */ 4;
+    str += strspn(str, "abcdefghijklmnopqrstuvwxyz_");
+    return MATCH_PREFIX(str, ": ");
+}
+
+/* record the input file of the TU so that db_update() can prune its info */
+static bool store_input(const char *dir, const char *key, const char *input)
+{
+    char *tmp_name = NULL;
+    char *src_name = NULL;
+    FILE *fp = NULL;
+    bool ok = false;
+
+    if (0 < asprintf(&tmp_name, "%s/.%s-XXXXXX", dir, key)) {
+        const int fd = mkostemp(tmp_name, O_CLOEXEC);
+        if (0 <= fd && !(fp = fdopen(fd, "w"))) {
+            close(fd);
+            unlink(tmp_name);
+        }
+    }
+
+    if (fp) {
+        fprintf(fp, "%s\n", input);
+        ok = !fclose(fp)
+            && (0 < asprintf(&src_name, "%s/%s.src", dir, key))
+            && !rename(tmp_name, src_name);
+        if (!ok)
+            unlink(tmp_name);
+    }
+
+    free(src_name);
+    free(tmp_name);
+    return ok;
+}
+
+void db_store_info(
+        const char                 *db_dir,
+        const char                 *out_file,
+        const char                 *key,
+        const char                 *input,
+        const bool                  complete)
+{
+    FILE *fp_out = fopen(out_file, "r");
+    unlink(out_file);
+    if (!fp_out) {
+        db_fail("failed to open '%s' (%s)", out_file, strerror(errno));
+        return;
+    }
+
+    /* write the info to a temporary file first */
+    char *dir = NULL;
+    char *tmp_name = NULL;
+    FILE *fp_info = NULL;
+    if (complete && (dir = info_dir(db_dir))
+            && (0 < asprintf(&tmp_name, "%s/.%s-XXXXXX", dir, key)))
+    {
+        const int fd = mkostemp(tmp_name, O_CLOEXEC);
+        if (0 <= fd && !(fp_info = fdopen(fd, "w"))) {
+            close(fd);
+            unlink(tmp_name);
+        }
+    }
+
+    char *line = NULL;
+    size_t len = 0;
+    while (-1 != getline(&line, &len, fp_out)) {
+        /* the scripts of smatch expect the output as it is */
+        if (fp_info)
+            fputs(line, fp_info);
+
+        if (!is_info_line(line))
+            /* pass diagnostic messages through */
+            fputs(line, stdout);
+    }
+
+    free(line);
+    fclose(fp_out);
+    fflush(stdout);
+
+    if (fp_info) {
+        /* make the info visible to db_update() as pending */
+        char *new_name = NULL;
+        if (fclose(fp_info)
+                || !store_input(dir, key, input)
+                || (asprintf(&new_name, "%s/%s.new", dir, key) < 0)
+                || rename(tmp_name, new_name))
+        {
+            db_fail("failed to store '%s' (%s)", tmp_name, strerror(errno));
+            unlink(tmp_name);
+        }
+
+        free(new_name);
+    }
+
+    free(tmp_name);
+    free(dir);
+}
+
+/* append string to a dynamic array of strings */
+static bool str_list_add(char ***plist, size_t *pcnt, const char *str)
+{
+    char *dup = strdup(str);
+    char **list = realloc(*plist, (*pcnt + 1) * sizeof(char *));
+    if (!dup || !list) {
+        free(dup);
+        if (list)
+            *plist = list;
+        return false;
+    }
+
+    list[(*pcnt)++] = dup;
+    *plist = list;
+    return true;
+}
+
+static bool str_list_has(char **list, const size_t cnt, const char *str)
+{
+    size_t i;
+    for (i = 0; i < cnt; ++i)
+        if (STREQ(list[i], str))
+            return true;
+
+    return false;
+}
+
+static void str_list_free(char **list, const size_t cnt)
+{
+    size_t i;
+    for (i = 0; i < cnt; ++i)
+        free(list[i]);
+
+    free(list);
+}
+
+/* return path to the info file of the TU identified by key */
+static char *info_path(const char *dir, const char *key, const char *suffix)
+{
+    char *path;
+    if (asprintf(&path, "%s/%s%s", dir, key, suffix) < 0)
+        return NULL;
+
+    return path;
+}
+
+/* append contents of the info file to stream */
+static bool append_info(FILE *fp_dst, const char *info_file)
+{
+    FILE *fp = fopen(info_file, "r");
+    if (!fp) {
+        db_fail("failed to open '%s' (%s)", info_file, strerror(errno));
+        return false;
+    }
+
+    char buf[BUFSIZ];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof buf, fp)))
+        fwrite(buf, 1, len, fp_dst);
+
+    const bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+/* return true if the input file of the TU identified by key was removed */
+static bool is_removed_tu(const char *dir, const char *key)
+{
+    char *src_name = info_path(dir, key, ".src");
+    FILE *fp = (src_name) ? fopen(src_name, "re") : NULL;
+    free(src_name);
+    if (!fp)
+        /* the input file is not known --> keep the info */
+        return false;
+
+    char *input = NULL;
+    size_t len = 0;
+    bool removed = false;
+    const ssize_t cnt = getline(&input, &len, fp);
+    if (1 < cnt && '\n' == input[cnt - 1]) {
+        input[cnt - 1] = '\0';
+        removed = access(input, F_OK) && (ENOENT == errno);
+    }
+
+    free(input);
+    fclose(fp);
+    return removed;
+}
+
+/* remove the info of TUs whose input file was removed, return their count */
+static size_t prune_removed_tus(const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return 0;
+
+    char **keys = NULL;
+    size_t cnt_keys = 0;
+    const struct dirent *de;
+    while ((de = readdir(d))) {
+        const char *name = de->d_name;
+        if (!has_suffix(name, ".src"))
+            continue;
+
+        char *key = strndup(name, strlen(name) - strlen(".src"));
+        if (key && is_removed_tu(dir, key))
+            str_list_add(&keys, &cnt_keys, key);
+
+        free(key);
+    }
+
+    closedir(d);
+
+    size_t i;
+    for (i = 0; i < cnt_keys; ++i) {
+        static const char *suffixes[] = { ".new", ".info", ".src", NULL };
+        const char **suffix;
+        for (suffix = suffixes; *suffix; ++suffix) {
+            char *path = info_path(dir, keys[i], *suffix);
+            if (path)
+                unlink(path);
+            free(path);
+        }
+    }
+
+    str_list_free(keys, cnt_keys);
+    return cnt_keys;
+}
+
+/* run create_db.sh of smatch on info_file in the work_dir */
+static int run_create_db(const char *work_dir, const char *info_file)
+{
+    const char *dir = getenv(db_scripts_envvar_name);
+    if (!dir || !dir[0])
+        dir = db_scripts_dir_default;
+
+    char *script;
+    if (asprintf(&script, "%s/create_db.sh", dir) < 0)
+        return EXIT_FAILURE;
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        free(script);
+        return db_fail("failed to fork() for '%s' (%s)", script,
+                strerror(errno));
+    }
+
+    if (pid == 0) {
+        /* the database is created in the current working directory */
+        if (chdir(work_dir))
+            _exit(EXIT_FAILURE);
+
+        execl(script, script, info_file, (char *) NULL);
+        db_fail("failed to exec '%s' (%s)", script, strerror(errno));
+        _exit(0x7F);
+    }
+
+    free(script);
+
+    int status;
+    while (-1 == waitpid(pid, &status, 0))
+        if (EINTR != errno)
+            return EXIT_FAILURE;
+
+    return (WIFEXITED(status))
+        ? WEXITSTATUS(status)
+        : 0x80 + WTERMSIG(status);
+}
+
+/* remove the work directory including all files created in there */
+static void remove_work_dir(const char *work_dir)
+{
+    DIR *d = opendir(work_dir);
+    if (d) {
+        const struct dirent *de;
+        while ((de = readdir(d)))
+            unlinkat(dirfd(d), de->d_name, /* flags */ 0);
+
+        closedir(d);
+    }
+
+    rmdir(work_dir);
+}
+
+int db_update(const char *db_dir)
+{
+    char *dir = info_dir(db_dir);
+    if (!dir)
+        return EXIT_FAILURE;
+
+    int status = EXIT_FAILURE;
+    char *lock_file = NULL;
+    char *db_file = NULL;
+    char *work_dir = NULL;
+    char *all_info = NULL;
+    char *db_created = NULL;
+    char **keys = NULL;
+    size_t cnt_keys = 0;
+    char **keys_old = NULL;
+    size_t cnt_keys_old = 0;
+    FILE *fp_info = NULL;
+    int fd_lock = -1;
+    size_t i;
+
+    /* serialize updates of the database */
+    if (asprintf(&lock_file, "%s/.lock", db_dir) < 0)
+        goto out;
+    fd_lock = open(lock_file, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd_lock < 0 || flock(fd_lock, LOCK_EX)) {
+        db_fail("failed to lock '%s' (%s)", lock_file, strerror(errno));
+        goto out;
+    }
+
+    if (asprintf(&db_file, "%s/%s", db_dir, db_base_name) < 0)
+        goto out;
+
+    /* the whole database is rebuilt, so drop the info of removed TUs first */
+    const size_t cnt_removed = prune_removed_tus(dir);
+
+    /* claim the pending info (*.new --> *.cur) and find the stored one */
+    DIR *d = opendir(dir);
+    if (!d) {
+        db_fail("failed to open '%s' (%s)", dir, strerror(errno));
+        goto out;
+    }
+
+    const struct dirent *de;
+    while ((de = readdir(d))) {
+        const char *name = de->d_name;
+        const bool is_new = has_suffix(name, ".new");
+        if (!is_new && !has_suffix(name, ".info"))
+            continue;
+
+        char *key = strndup(name, strlen(name)
+                - strlen((is_new) ? ".new" : ".info"));
+        if (!key)
+            continue;
+
+        if (!is_new) {
+            str_list_add(&keys_old, &cnt_keys_old, key);
+            free(key);
+            continue;
+        }
+
+        char *path_new = info_path(dir, key, ".new");
+        char *path_cur = info_path(dir, key, ".cur");
+        if (path_new && path_cur && !rename(path_new, path_cur))
+            str_list_add(&keys, &cnt_keys, key);
+
+        free(path_cur);
+        free(path_new);
+        free(key);
+    }
+
+    closedir(d);
+
+    if (!cnt_keys && !cnt_removed && !access(db_file, F_OK)) {
+        /* nothing changed since the last update */
+        status = EXIT_SUCCESS;
+        goto out;
+    }
+
+    /* the scripts of smatch create the database in a work directory */
+    if (asprintf(&work_dir, "%s/.update-XXXXXX", db_dir) < 0) {
+        work_dir = NULL;
+        goto out;
+    }
+    if (!mkdtemp(work_dir)) {
+        db_fail("failed to create '%s' (%s)", work_dir, strerror(errno));
+        free(work_dir);
+        work_dir = NULL;
+        goto out;
+    }
+
+    /* concatenate the info of all TUs as if smatch was run on all of them */
+    if (asprintf(&all_info, "%s/smatch_warns.txt", work_dir) < 0) {
+        all_info = NULL;
+        goto out;
+    }
+    fp_info = fopen(all_info, "we");
+    if (!fp_info) {
+        db_fail("failed to create '%s' (%s)", all_info, strerror(errno));
+        goto out;
+    }
+
+    bool info_ok = true;
+    for (i = 0; i < cnt_keys; ++i) {
+        char *path = info_path(dir, keys[i], ".cur");
+        info_ok &= path && append_info(fp_info, path);
+        free(path);
+    }
+
+    for (i = 0; i < cnt_keys_old; ++i) {
+        if (str_list_has(keys, cnt_keys, keys_old[i]))
+            /* superseded by the pending info */
+            continue;
+
+        char *path = info_path(dir, keys_old[i], ".info");
+        info_ok &= path && append_info(fp_info, path);
+        free(path);
+    }
+
+    info_ok &= !fclose(fp_info);
+    fp_info = NULL;
+    if (!info_ok) {
+        db_fail("failed to write '%s'", all_info);
+        goto out;
+    }
+
+    /* the new database replaces the old one at once */
+    status = run_create_db(work_dir, all_info);
+    if (!status && ((asprintf(&db_created, "%s/%s", work_dir, db_base_name)
+                    < 0) || rename(db_created, db_file)))
+    {
+        db_fail("failed to create '%s' (%s)", db_file, strerror(errno));
+        status = EXIT_FAILURE;
+    }
+
+out:
+    for (i = 0; i < cnt_keys; ++i) {
+        char *path_cur = info_path(dir, keys[i], ".cur");
+        char *path_dst = info_path(dir, keys[i], (status) ? ".new" : ".info");
+        if (path_cur && path_dst) {
+            if (!status)
+                /* the info is in the database now */
+                rename(path_cur, path_dst);
+            else if (link(path_cur, path_dst) && (EEXIST != errno))
+                /* keep the info pending unless superseded meanwhile */
+                db_fail("failed to restore '%s' (%s)", path_dst,
+                        strerror(errno));
+        }
+
+        if (status && path_cur)
+            unlink(path_cur);
+
+        free(path_dst);
+        free(path_cur);
+    }
+
+    if (fp_info)
+        fclose(fp_info);
+    if (work_dir)
+        remove_work_dir(work_dir);
+    if (0 <= fd_lock)
+        close(fd_lock);
+
+    str_list_free(keys_old, cnt_keys_old);
+    str_list_free(keys, cnt_keys);
+    free(db_created);
+    free(all_info);
+    free(work_dir);
+    free(db_file);
+    free(lock_file);
+    free(dir);
+    return status;
+}
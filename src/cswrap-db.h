@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This file is part of cscppc.
+ *
+ * cscppc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * cscppc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cscppc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CSWRAP_DB_H
+#define CSWRAP_DB_H
+
+#include <stdbool.h>
+
+/**
+ * Return the analyzer arg that makes smatch use the cross-function database
+ * maintained in db_dir, or NULL if the database does not exist yet.  The
+ * returned string needs to be released by free().
+ */
+char *db_analyzer_arg(const char *db_dir);
+
+/**
+ * Create a temporary file in db_dir to capture output of the analyzer.
+ * Returns its file descriptor, or -1 on error.  The name of the file is
+ * returned via *pname and needs to be released by free().
+ */
+int db_create_output(const char *db_dir, char **pname);
+
+/**
+ * Pass diagnostic messages from the captured output of the analyzer to
+ * standard output.  If the analysis is complete, the output is stored in
+ * db_dir as pending info about the TU identified by key, together with the
+ * absolute path of its input file.  The output file is removed.
+ */
+void db_store_info(
+        const char                 *db_dir,
+        const char                 *out_file,
+        const char                 *key,
+        const char                 *input,
+        const bool                  complete);
+
+/**
+ * Rebuild the whole cross-function database in db_dir by create_db.sh of
+ * smatch from the stored info of all TUs unless no TU has changed since the
+ * last update.  The info of TUs whose input file no longer exists is removed
+ * first.  The database is replaced at once.
+ */
+int db_update(const char *db_dir);
+
+#endif /* CSWRAP_DB_H */
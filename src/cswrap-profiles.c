@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2013-2026 Red Hat, Inc.
+ *
+ * This file is part of cscppc.
+ *
+ * cscppc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * cscppc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cscppc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cswrap-core.h"
+
+#include <bits/wordsize.h>
+#include <stddef.h>
+
+#ifndef PATH_TO_CSCPPC
+#define PATH_TO_CSCPPC ""
+#endif
+
+#ifndef PATH_TO_CSCLNG
+#define PATH_TO_CSCLNG ""
+#endif
+
+#ifndef PATH_TO_CSGCCA
+#define PATH_TO_CSGCCA ""
+#endif
+
+#ifndef PATH_TO_CSMATCH
+#define PATH_TO_CSMATCH ""
+#endif
+
+/* number of items in an arg list, including the terminating NULL */
+#define ARGC(list) ((int) (sizeof(list)/sizeof((list)[0])))
+
+static const char *no_args[] = {
+    NULL
+};
+
+/* cscppc */
+static const char *cscppc_def_args[] = {
+    "-D__GNUC__",
+    "-D__STDC__",
+#if __WORDSIZE == 32
+    "-D__i386__",
+    "-D__WORDSIZE=32",
+#elif __WORDSIZE == 64
+    "-D__x86_64__",
+    "-D__WORDSIZE=64",
+#else
+#error "Unknown word size"
+#endif
+    "-D__CPPCHECK__",
+    "--inline-suppr",
+    "--quiet",
+    "--template={file}:{line}: {severity}: {id}(CWE-{cwe}): {message}",
+    "--suppressions-list=/usr/share/cscppc/default.supp",
+    NULL
+};
+
+static const char *cscppc_deep_args[] = {
+    /* the checks may take significantly longer in this mode */
+    "--check-level=exhaustive",
+
+    NULL
+};
+
+/* csclng, csclng++ */
+static const char *csclng_def_args[] = {
+    "--analyze",
+
+    /* write error traces to stderr instead of creating .plist files */
+    "-Xanalyzer",
+    "-analyzer-output=text",
+    "-fno-caret-diagnostics",
+
+    NULL
+};
+
+static const char *csclng_deep_args[] = {
+    /* unroll loops more times than by default (4) */
+    "-Xanalyzer",
+    "-analyzer-max-loop",
+    "-Xanalyzer",
+    "16",
+
+    NULL
+};
+
+/* csgcca */
+static const char *csgcca_def_args[] = {
+    "-fanalyzer",
+    "-fdiagnostics-path-format=separate-events",
+    "-fno-diagnostics-show-caret",
+
+    /* do not create any object files, only emit diagnostic messages */
+    "-c",
+    "-o",
+    "/dev/null",
+
+    NULL
+};
+
+static const char *csgcca_fast_args[] = {
+    /* keep the exploded graph small to finish quickly */
+    "--param=analyzer-bb-explosion-factor=2",
+    "--param=analyzer-max-enodes-per-program-point=4",
+
+    NULL
+};
+
+static const char *csgcca_deep_args[] = {
+    /* let the exploded graph grow much more than by default */
+    "--param=analyzer-bb-explosion-factor=20",
+    "--param=analyzer-max-enodes-per-program-point=32",
+
+    NULL
+};
+
+static const char *csgcca_del_args[] = {
+    /* we run `gcc -fanalyzer` in a separate process --> do not use the flag
+     * while compiling production binaries */
+    "-fanalyzer",
+    NULL
+};
+
+/* csmatch */
+static const char *csmatch_def_args[] = {
+    "-D_Float128=long double",
+    NULL
+};
+
+const struct wrapper_profile wrapper_profiles[] = {
+    {
+        .wrapper_name                   = "cscppc",
+        .wrapper_path                   = PATH_TO_CSCPPC,
+        .wrapper_proc_prefix            = "[cscppc] ",
+        .wrapper_addopts_envvar_name    = "CSCPPC_ADD_OPTS",
+        .wrapper_debug_envvar_name      = "DEBUG_CSCPPC",
+        .wrapper_defer_envvar_name      = "CSCPPC_DEFER_DIR",
+        .analyzer_name                  = "cppcheck",
+        .analyzer_is_cxx_ready          = true,
+        .analyzer_is_gcc_compatible     = false,
+        .analyzer_reads_pp_input        = false,
+        .analyzer_def_argv              = cscppc_def_args,
+        .analyzer_def_argc              = ARGC(cscppc_def_args),
+        .analyzer_fast_argv             = no_args,
+        .analyzer_fast_argc             = ARGC(no_args),
+        .analyzer_deep_argv             = cscppc_deep_args,
+        .analyzer_deep_argc             = ARGC(cscppc_deep_args),
+    },
+    {
+        .wrapper_name                   = "csclng",
+        .wrapper_path                   = PATH_TO_CSCLNG,
+        .wrapper_proc_prefix            = "[csclng] ",
+        .wrapper_addopts_envvar_name    = "CSCLNG_ADD_OPTS",
+        .wrapper_debug_envvar_name      = "DEBUG_CSCLNG",
+        .wrapper_defer_envvar_name      = "CSCLNG_DEFER_DIR",
+        .analyzer_name                  = "clang",
+        .analyzer_is_cxx_ready          = true,
+        .analyzer_is_gcc_compatible     = true,
+        .analyzer_reads_pp_input        = false,
+        .analyzer_def_argv              = csclng_def_args,
+        .analyzer_def_argc              = ARGC(csclng_def_args),
+        .analyzer_fast_argv             = no_args,
+        .analyzer_fast_argc             = ARGC(no_args),
+        .analyzer_deep_argv             = csclng_deep_args,
+        .analyzer_deep_argc             = ARGC(csclng_deep_args),
+    },
+    {
+        .wrapper_name                   = "csclng++",
+        .wrapper_path                   = PATH_TO_CSCLNG,
+        .wrapper_proc_prefix            = "[csclng++] ",
+        .wrapper_addopts_envvar_name    = "CSCLNG_ADD_OPTS",
+        .wrapper_debug_envvar_name      = "DEBUG_CSCLNG",
+        .wrapper_defer_envvar_name      = "CSCLNG_DEFER_DIR",
+        .analyzer_name                  = "clang++",
+        .analyzer_is_cxx_ready          = true,
+        .analyzer_is_gcc_compatible     = true,
+        .analyzer_reads_pp_input        = false,
+        .analyzer_def_argv              = csclng_def_args,
+        .analyzer_def_argc              = ARGC(csclng_def_args),
+        .analyzer_fast_argv             = no_args,
+        .analyzer_fast_argc             = ARGC(no_args),
+        .analyzer_deep_argv             = csclng_deep_args,
+        .analyzer_deep_argc             = ARGC(csclng_deep_args),
+    },
+    {
+        .wrapper_name                   = "csgcca",
+        .wrapper_path                   = PATH_TO_CSGCCA,
+        .wrapper_proc_prefix            = "[csgcca] ",
+        .wrapper_addopts_envvar_name    = "CSGCCA_ADD_OPTS",
+        .wrapper_debug_envvar_name      = "DEBUG_CSGCCA",
+        .wrapper_defer_envvar_name      = "CSGCCA_DEFER_DIR",
+        .analyzer_name                  = "gcc",
+        .analyzer_bin_envvar_name       = "CSGCCA_ANALYZER_BIN",
+        .analyzer_is_cxx_ready          = false,
+        .analyzer_is_gcc_compatible     = true,
+        .analyzer_reads_pp_input        = true,
+        .analyzer_def_argv              = csgcca_def_args,
+        .analyzer_def_argc              = ARGC(csgcca_def_args),
+        .analyzer_fast_argv             = csgcca_fast_args,
+        .analyzer_fast_argc             = ARGC(csgcca_fast_args),
+        .analyzer_deep_argv             = csgcca_deep_args,
+        .analyzer_deep_argc             = ARGC(csgcca_deep_args),
+        .compiler_del_args              = csgcca_del_args,
+    },
+    {
+        .wrapper_name                   = "csmatch",
+        .wrapper_path                   = PATH_TO_CSMATCH,
+        .wrapper_proc_prefix            = "[csmatch] ",
+        .wrapper_addopts_envvar_name    = "CSMATCH_ADD_OPTS",
+        .wrapper_debug_envvar_name      = "DEBUG_CSMATCH",
+        .wrapper_defer_envvar_name      = "CSMATCH_DEFER_DIR",
+        .analyzer_db_envvar_name        = "CSMATCH_DB_DIR",
+        .analyzer_name                  = "smatch",
+        .analyzer_is_cxx_ready          = false,
+        .analyzer_is_gcc_compatible     = true,
+        .analyzer_reads_pp_input        = false,
+        .analyzer_def_argv              = csmatch_def_args,
+        .analyzer_def_argc              = ARGC(csmatch_def_args),
+        .analyzer_fast_argv             = no_args,
+        .analyzer_fast_argc             = ARGC(no_args),
+        .analyzer_deep_argv             = no_args,
+        .analyzer_deep_argc             = ARGC(no_args),
+    },
+    /* table terminator */
+    { .wrapper_name = NULL }
+};
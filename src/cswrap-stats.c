@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This file is part of cscppc.
+ *
+ * cscppc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * cscppc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cscppc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "cswrap-stats.h"
+#include "cswrap-core.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* name of the build session, the statistics are collected only if set */
+static const char *stats_session_envvar_name = "CSCPPC_STATS_SESSION";
+
+/* bump if the layout of the shared memory segment changes */
+#define STATS_VERSION 1
+
+/* layout of the shared memory segment, updated by lock-free atomic ops */
+struct stats_shm {
+    unsigned                    version;
+    long long                   items[STATS_ITEMS];
+};
+
+/* labels of the items printed by stats_print() */
+static const struct {
+    const char                 *label;
+    bool                        usec;
+} stats_items[STATS_ITEMS] = {
+    [STATS_ANALYZERS_RUNNING]       = { "analyzers running:",      false },
+    [STATS_ANALYZERS_QUEUED]        = { "analyzers queued:",       false },
+    [STATS_ANALYZERS_FINISHED]      = { "analyzers finished:",     false },
+    [STATS_ANALYZERS_KILLED]        = { "analyzers killed:",       false },
+    [STATS_ANALYZER_CPU_USEC]       = { "analyzer CPU time:",      true  },
+    [STATS_ANALYZER_WALL_USEC]      = { "analyzer wall time:",     true  },
+    [STATS_DIAG_BYTES]              = { "diagnostics (bytes):",    false },
+    [STATS_SKIP_PREPROCESS_ONLY]    = { "skipped (-E):",           false },
+    [STATS_SKIP_DEPS_ONLY]          = { "skipped (-M*):",          false },
+    [STATS_SKIP_IGNORED_FILE]       = { "skipped (ignored file):", false },
+    [STATS_SKIP_NO_INPUT]           = { "skipped (no input):",     false },
+};
+
+/* the shared memory segment of the session, NULL if not enabled */
+static struct stats_shm *stats_shm;
+
+/* start of the analyzer and CPU time of the children reaped until then */
+static struct timespec analyzer_start;
+static long long children_cpu_usec;
+
+/* print error and return EXIT_FAILURE */
+static int stats_fail(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+
+    fprintf(stderr, "%s: error: ", profile->wrapper_name);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+
+    va_end(ap);
+    return EXIT_FAILURE;
+}
+
+/* return name of the shared memory segment of the session, NULL if none */
+static char *stats_shm_name(const char *session)
+{
+    if (strchr(session, '/')) {
+        stats_fail("invalid %s: %s", stats_session_envvar_name, session);
+        return NULL;
+    }
+
+    char *name;
+    if (asprintf(&name, "/cscppc-stats-%s", session) < 0)
+        return NULL;
+
+    return name;
+}
+
+bool stats_enabled(void)
+{
+    static bool initialized;
+    if (initialized)
+        return !!stats_shm;
+
+    initialized = true;
+    const char *session = getenv(stats_session_envvar_name);
+    if (!session || !session[0])
+        return false;
+
+    char *name = stats_shm_name(session);
+    if (!name)
+        return false;
+
+    const int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        stats_fail("failed to open '%s' (%s)", name, strerror(errno));
+        free(name);
+        return false;
+    }
+
+    /* the first wrapper of the session creates the (zero-filled) segment */
+    const size_t size = sizeof(struct stats_shm);
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (!fstat(fd, &st)
+            && ((size_t) st.st_size >= size || !ftruncate(fd, size)))
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED == addr)
+        stats_fail("failed to map '%s' (%s)", name, strerror(errno));
+
+    close(fd);
+    free(name);
+    if (MAP_FAILED == addr)
+        return false;
+
+    /* do not touch segments created by an incompatible version */
+    struct stats_shm *shm = addr;
+    unsigned version = 0;
+    if (!__atomic_compare_exchange_n(&shm->version, &version, STATS_VERSION,
+                /* weak */ false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+            && STATS_VERSION != version)
+    {
+        munmap(addr, size);
+        return false;
+    }
+
+    stats_shm = shm;
+    return true;
+}
+
+void stats_add(const enum stats_item item, const long long delta)
+{
+    if (delta && stats_enabled())
+        __atomic_fetch_add(&stats_shm->items[item], delta, __ATOMIC_RELAXED);
+}
+
+/* CPU time of the reaped children of this process in microseconds */
+static long long children_cpu_usec_now(void)
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_CHILDREN, &ru))
+        return children_cpu_usec;
+
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL
+        + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+void stats_analyzer_started(void)
+{
+    if (!stats_enabled())
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &analyzer_start);
+    children_cpu_usec = children_cpu_usec_now();
+    stats_add(STATS_ANALYZERS_RUNNING, 1);
+}
+
+void stats_child_reaped(const bool analyzer, const int status)
+{
+    if (!stats_enabled())
+        return;
+
+    const long long cpu_now = children_cpu_usec_now();
+    if (analyzer) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const long long wall =
+            (now.tv_sec - analyzer_start.tv_sec) * 1000000LL
+            + (now.tv_nsec - analyzer_start.tv_nsec) / 1000;
+
+        stats_add(STATS_ANALYZER_CPU_USEC, cpu_now - children_cpu_usec);
+        stats_add(STATS_ANALYZER_WALL_USEC, wall);
+        stats_add(STATS_ANALYZERS_RUNNING, -1);
+        stats_add(STATS_ANALYZERS_FINISHED, 1);
+        if (0x80 <= status)
+            /* terminated by a signal */
+            stats_add(STATS_ANALYZERS_KILLED, 1);
+    }
+
+    children_cpu_usec = cpu_now;
+}
+
+int stats_print(void)
+{
+    const char *session = getenv(stats_session_envvar_name);
+    if (!session || !session[0])
+        return stats_fail("%s is not set", stats_session_envvar_name);
+
+    char *name = stats_shm_name(session);
+    if (!name)
+        return EXIT_FAILURE;
+
+    const int fd = shm_open(name, O_RDONLY, 0);
+    free(name);
+    if (fd < 0)
+        return stats_fail("no statistics of session '%s' (%s)", session,
+                strerror(errno));
+
+    const size_t size = sizeof(struct stats_shm);
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (!fstat(fd, &st) && (size_t) st.st_size >= size)
+        addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+    if (MAP_FAILED == addr)
+        return stats_fail("invalid statistics of session '%s'", session);
+
+    const struct stats_shm *shm = addr;
+    if (STATS_VERSION != __atomic_load_n(&shm->version, __ATOMIC_RELAXED)) {
+        munmap(addr, size);
+        return stats_fail("incompatible statistics of session '%s'",
+                session);
+    }
+
+    printf("%-24s%s\n", "build session:", session);
+
+    int i;
+    for (i = 0; i < STATS_ITEMS; ++i) {
+        const long long val =
+            __atomic_load_n(&shm->items[i], __ATOMIC_RELAXED);
+
+        if (stats_items[i].usec)
+            printf("%-24s%lld.%03lld s\n", stats_items[i].label,
+                    val / 1000000, val / 1000 % 1000);
+        else
+            printf("%-24s%lld\n", stats_items[i].label, val);
+    }
+
+    munmap(addr, size);
+    return EXIT_SUCCESS;
+}
+
+int stats_remove(void)
+{
+    const char *session = getenv(stats_session_envvar_name);
+    if (!session || !session[0])
+        return stats_fail("%s is not set", stats_session_envvar_name);
+
+    char *name = stats_shm_name(session);
+    if (!name)
+        return EXIT_FAILURE;
+
+    const int rv = shm_unlink(name);
+    free(name);
+    if (rv)
+        return stats_fail("no statistics of session '%s' (%s)", session,
+                strerror(errno));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This file is part of cscppc.
+ *
+ * cscppc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * cscppc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cscppc.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CSWRAP_STATS_H
+#define CSWRAP_STATS_H
+
+#include <stdbool.h>
+
+/* counters and gauges shared by all wrappers of a build session */
+enum stats_item {
+    STATS_ANALYZERS_RUNNING,
+    STATS_ANALYZERS_QUEUED,
+    STATS_ANALYZERS_FINISHED,
+    STATS_ANALYZERS_KILLED,
+    STATS_ANALYZER_CPU_USEC,
+    STATS_ANALYZER_WALL_USEC,
+    STATS_DIAG_BYTES,
+    STATS_SKIP_PREPROCESS_ONLY,
+    STATS_SKIP_DEPS_ONLY,
+    STATS_SKIP_IGNORED_FILE,
+    STATS_SKIP_NO_INPUT,
+    STATS_ITEMS
+};
+
+/**
+ * Return true if the statistics are collected, which is the case if the name
+ * of the build session is set in the environment.  The shared memory segment
+ * of the session is created (or attached) on the first call.
+ */
+bool stats_enabled(void);
+
+/* atomically add delta to the given item (no-op if not enabled) */
+void stats_add(const enum stats_item item, const long long delta);
+
+/* account start of the analyzer run by this process */
+void stats_analyzer_started(void);
+
+/**
+ * Account a child process reaped by this process.  The CPU time of children
+ * reaped since the analyzer started is not accounted to the analyzer.
+ */
+void stats_child_reaped(const bool analyzer, const int status);
+
+/* print a snapshot of the statistics of the build session */
+int stats_print(void);
+
+/* remove the shared memory segment of the build session */
+int stats_remove(void);
+
+#endif /* CSWRAP_STATS_H */
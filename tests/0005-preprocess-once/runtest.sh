@@ -0,0 +1,117 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tools
+PATH_ORIG="$PWD/tools:$PATH"
+
+WRAPPERS="cscppc csclng csgcca"
+for wrap in $WRAPPERS; do
+    mkdir -p $wrap
+    ln -fs "$PATH_TO_WRAP/$wrap" $wrap/gcc                          || exit $?
+    PATH_ALL="${PATH_ALL}$PWD/$wrap:"
+done
+
+# chain all the wrappers
+export PATH="${PATH_ALL}${PATH_ORIG}"
+
+# create faked compiler that can also preprocess (-E) slowly and that is also
+# used by csgcca as the analyzer (-fanalyzer)
+printf '#!/bin/bash
+for arg in "$@"; do
+    test "-fanalyzer" = "$arg" && exec gcc-analyzer "$@"
+done
+printf "%%s\\n" "$*" >> gcc-args.txt
+for arg in "$@"; do
+    test "-E" = "$arg" && pp=yes
+    test "-DFAIL_PP" = "$arg" && fail=yes
+    test "-o" = "$prev" && out="$arg"
+    prev="$arg"
+done
+if test yes != "$pp"; then
+    touch compiled.txt
+    exit 0
+fi
+test yes = "$fail" && exit 1
+sleep 1
+test -e compiled.txt && touch compiled-meanwhile.txt
+echo "/* preprocessed */" > "$out"
+' > tools/gcc                                                       || exit $?
+
+# create faked analyzers that record args and contents of the input file
+printf '#!/bin/bash
+tool="$(basename "$0")"
+printf "%%s\\n" "$*" > "${tool}-args.txt"
+for arg in "$@"; do
+    case "$arg" in
+        *.c|*.i)
+            cat "$arg" > "${tool}-input.txt"
+            ;;
+    esac
+done
+' | tee tools/{cppcheck,clang,gcc-analyzer}                         || exit $?
+chmod 0755 tools/{gcc,cppcheck,clang,gcc-analyzer}                  || exit $?
+
+echo "/* original */" > test.c                                      || exit $?
+echo "/* original */" > main.c                                      || exit $?
+
+# the preprocess-once mode is disabled by default
+rm -f *.txt
+gcc -Iinc -DX=1 -c test.c -o test.o                                 || exit $?
+grep -- "-E" gcc-args.txt                                           && exit 1
+grep "^-Iinc -DX=1 test.c " clang-args.txt                          || exit $?
+grep "^-Iinc -DX=1 test.c " cppcheck-args.txt                       || exit $?
+grep "original" cppcheck-input.txt                                  || exit $?
+grep "original" gcc-analyzer-input.txt                              || exit $?
+
+# preprocess only once and share the result along the chain
+export CSCPPC_PREPROCESS_ONCE=1
+export TMPDIR="$PWD/tmp"
+mkdir -p "$TMPDIR"
+rm -f *.txt
+gcc -Iinc -DX=1 -Wall -m64 -c test.c -o test.o                      || exit $?
+test 2 = "$(wc -l < gcc-args.txt)"                                  || exit $?
+grep "^-E -C -Iinc -DX=1 -m64 test.c -o /.*-.*\.i$" gcc-args.txt    || exit $?
+grep -- "-Iinc" gcc-analyzer-args.txt                               && exit 1
+grep -- "-DX=1" gcc-analyzer-args.txt                               && exit 1
+grep -- " test.c " gcc-analyzer-args.txt                            && exit 1
+grep " /.*-.*\.i " gcc-analyzer-args.txt                            || exit $?
+grep "preprocessed" gcc-analyzer-input.txt                          || exit $?
+
+# the compiler does not wait for the preprocessor
+test -e compiled-meanwhile.txt                                      || exit $?
+
+# clang predefines different macros than the compiler that has preprocessed
+grep "^-Iinc -DX=1 -m64 test.c " clang-args.txt                     || exit $?
+grep "original" clang-input.txt                                     || exit $?
+
+# cppcheck does not read the preprocessed file with expanded system headers
+grep "^-Iinc -DX=1 test.c " cppcheck-args.txt                       || exit $?
+grep "original" cppcheck-input.txt                                  || exit $?
+
+# the temporary file is removed once all analyzers have finished
+test -z "$(ls /dev/shm/cscppc-* "$TMPDIR"/cscppc-* 2>/dev/null)"   || exit $?
+
+# the analyzers preprocess on their own if the preprocessor fails
+rm -f *.txt
+gcc -DFAIL_PP -c test.c                                             || exit $?
+grep "original" clang-input.txt                                     || exit $?
+grep "original" gcc-analyzer-input.txt                              || exit $?
+
+# nothing is preprocessed in advance if no analyzer matches the compiler
+rm -f *.txt
+CSGCCA_ANALYZER_BIN=gcc-analyzer gcc -c test.c                      || exit $?
+test 1 = "$(wc -l < gcc-args.txt)"                                  || exit $?
+grep "original" gcc-analyzer-input.txt                              || exit $?
+
+# nothing is preprocessed in advance for analyzers that do not read it
+rm -f *.txt
+PATH="$PWD/csclng:$PWD/cscppc:$PATH_ORIG" gcc -c test.c             || exit $?
+test 1 = "$(wc -l < gcc-args.txt)"                                  || exit $?
+grep "original" clang-input.txt                                     || exit $?
+
+# multiple input files are preprocessed by the analyzers themselves
+rm -f *.txt
+gcc -Iinc -c test.c main.c                                          || exit $?
+test 1 = "$(wc -l < gcc-args.txt)"                                  || exit $?
+grep "^-Iinc test.c main.c " clang-args.txt                         || exit $?
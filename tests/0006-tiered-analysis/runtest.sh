@@ -0,0 +1,69 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tools wrap
+export PATH="$PWD/wrap:$PWD/tools:$PATH"
+
+# create faked compilers and analyzers
+printf '#!/bin/sh
+tool="$(basename "$0")"
+printf "%%s\\n" "$*" >> "${tool}-args.txt"\n' \
+    | tee tools/{gcc,cppcheck}                                      || exit $?
+chmod 0755 tools/{gcc,cppcheck}                                     || exit $?
+
+# create symlinks to wrappers
+ln -fs "$PATH_TO_WRAP/cscppc" wrap/gcc                              || exit $?
+
+# the deep analysis is not queued by default
+rm -f *.txt
+gcc -DX=1 -c test.c                                                 || exit $?
+test 1 = "$(wc -l < cppcheck-args.txt)"                             || exit $?
+grep -- "--check-level=exhaustive" cppcheck-args.txt                && exit 1
+
+# run the cheap tier in background and queue the expensive tier
+export CSCPPC_DEFER_DIR="$PWD/queue"
+mkdir -p "$CSCPPC_DEFER_DIR"
+rm -f *.txt
+gcc -DX=1 -c test.c                                                 || exit $?
+gcc -DX=2 -c main.c                                                 || exit $?
+test 2 = "$(wc -l < cppcheck-args.txt)"                             || exit $?
+grep -- "--check-level=exhaustive" cppcheck-args.txt                && exit 1
+test 2 = "$(ls queue/*.job | wc -l)"                                || exit $?
+
+# nothing is queued if the compilation fails
+printf 'case "$*" in *broken.c*) exit 1 ;; esac\n' >> tools/gcc     || exit $?
+gcc -c broken.c                                                     && exit 1
+test 2 = "$(ls queue/*.job | wc -l)"                                || exit $?
+test -z "$(ls queue/*.tmp 2>/dev/null)"                             || exit $?
+
+# invalid number of jobs
+"$PATH_TO_WRAP/cscppc" --run-deferred=0                             && exit 1
+"$PATH_TO_WRAP/cscppc" --run-deferred=x                             && exit 1
+test 2 = "$(ls queue/*.job | wc -l)"                                || exit $?
+
+# run the queued jobs from a different directory
+rm -f *.txt
+mkdir -p elsewhere
+(cd elsewhere && "$PATH_TO_WRAP/cscppc" --run-deferred=2)           || exit $?
+test 2 = "$(wc -l < cppcheck-args.txt)"                             || exit $?
+grep "^-DX=1 test.c .*--check-level=exhaustive" cppcheck-args.txt   || exit $?
+grep "^-DX=2 main.c .*--check-level=exhaustive" cppcheck-args.txt   || exit $?
+test -z "$(ls queue)"                                               || exit $?
+
+# the batch run fails if any job is killed or cannot be executed
+printf 'case "$*" in *killed.c*exhaustive*) kill -KILL $$ ;; esac\n' \
+    >> tools/cppcheck                                               || exit $?
+gcc -c killed.c                                                     || exit $?
+gcc -c test.c                                                       || exit $?
+"$PATH_TO_WRAP/cscppc" --run-deferred=2                             && exit 1
+test -z "$(ls queue)"                                               || exit $?
+gcc -c test.c                                                       || exit $?
+PATH="$PWD/wrap" "$PATH_TO_WRAP/cscppc" --run-deferred              && exit 1
+test -z "$(ls queue)"                                               || exit $?
+"$PATH_TO_WRAP/cscppc" --run-deferred                               || exit $?
+
+# the batch run needs the queue directory
+unset CSCPPC_DEFER_DIR
+"$PATH_TO_WRAP/cscppc" --run-deferred                               && exit 1
+exit 0
@@ -0,0 +1,86 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tool wrap
+export PATH="$PWD/wrap:$PWD/tool:$PATH"
+
+# create faked compiler and slow analyzer that does not pass signals on to
+# its child process (the same as the gcc driver does not pass them to cc1)
+printf '#!/bin/bash\ntrue\n' > tool/cc                              || exit $?
+printf '#!/bin/bash
+sleep 64 &
+echo "$!" >> children.pids
+echo "$$" >> cppcheck.pids
+wait $!\n' > tool/cppcheck                                          || exit $?
+chmod 0755 tool/{cc,cppcheck}                                       || exit $?
+
+# create symlink to cscppc
+ln -fs "$PATH_TO_WRAP/cscppc" wrap/cc                               || exit $?
+
+# use a private registry of analyses
+export XDG_RUNTIME_DIR="$PWD/run"
+mkdir -p "$XDG_RUNTIME_DIR"
+export CSCPPC_SUPERSEDE_ANALYSIS=1
+
+wait_for_analyzers() {
+    for i in $(seq 100); do
+        test "$1" = "$(wc -l < cppcheck.pids)" && return 0
+        sleep .1
+    done 2>/dev/null
+    return 1
+}
+
+is_running() {
+    kill -0 "$(sed -n "$1p" cppcheck.pids)"
+}
+
+child_is_running() {
+    kill -0 "$(sed -n "$1p" children.pids)"
+}
+
+# the terminated child process may take a while to be reaped
+wait_for_child_exit() {
+    for i in $(seq 20); do
+        child_is_running "$1" || return 0
+        sleep .1
+    done 2>/dev/null
+    return 1
+}
+
+# start analysis of test.c
+rm -f cppcheck.pids children.pids
+cc -c test.c -o test.o &
+pid_wrap1="$!"
+wait_for_analyzers 1                                                || exit $?
+is_running 1                                                        || exit $?
+
+# recompile test.c --> the stale analyzer is terminated
+cc -c test.c -o test.o &
+pid_wrap2="$!"
+wait_for_analyzers 2                                                || exit $?
+wait "$pid_wrap1"                                                   || exit $?
+is_running 1                                                        && exit 1
+is_running 2                                                        || exit $?
+
+# the child processes of the stale analyzer are terminated, too
+wait_for_child_exit 1                                               || exit $?
+child_is_running 2                                                  || exit $?
+
+# compilation of test.c into a different object file does not interfere
+cc -c test.c -o other.o &
+pid_wrap3="$!"
+wait_for_analyzers 3                                                || exit $?
+sleep .5
+is_running 2                                                        || exit $?
+is_running 3                                                        || exit $?
+
+# terminate the remaining analyses
+kill "$pid_wrap2" "$pid_wrap3"                                      || exit $?
+wait "$pid_wrap2"
+wait "$pid_wrap3"
+wait_for_child_exit 2                                               || exit $?
+wait_for_child_exit 3                                               || exit $?
+
+# the registry entries are removed once the analyses finish
+test -z "$(ls run/cscppc | grep -v "^resolved-")"                   || exit $?
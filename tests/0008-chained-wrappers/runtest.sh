@@ -0,0 +1,111 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tools
+PATH="$PWD/tools:$PATH"
+
+WRAPPERS="csclng csgcca cscppc"
+for wrap in $WRAPPERS; do
+    mkdir -p $wrap
+    ln -fs "$PATH_TO_WRAP/$wrap" $wrap/gcc                          || exit $?
+    PATH="$PWD/$wrap:$PATH"
+done
+
+export PATH
+
+# keep the cached resolution of the chain apart from other tests
+export XDG_RUNTIME_DIR="$PWD/run"
+rm -rf run && mkdir run                                             || exit $?
+
+# create faked compiler and analyzers
+printf '#!/bin/bash
+tool="$(basename "$0")"
+echo "$$" >> "${tool}.pids"\n' \
+    | tee tools/{gcc,gcca,cppcheck,clang}                           || exit $?
+export CSGCCA_ANALYZER_BIN=gcca
+echo 'printf "%s\n" "$PATH" > gcc-path.txt' >> tools/gcc            || exit $?
+echo 'printf "%s" "$CSCPPC_RESOLVED" > gcc-resolved.txt' >> tools/gcc \
+                                                                    || exit $?
+cp tools/gcc tools/evil                                             || exit $?
+cp tools/cppcheck tools/evil-cppcheck                               || exit $?
+chmod 0755 tools/{gcc,gcca,evil,cppcheck,evil-cppcheck,clang}       || exit $?
+
+# all wrappers in the chain run their analyzers, the compiler runs only once
+rm -f *.pids
+gcc -c test.c                                                       || exit $?
+test 1 = "$(wc -l < gcc.pids)"                                      || exit $?
+test 1 = "$(wc -l < gcca.pids)"                                     || exit $?
+test 1 = "$(wc -l < clang.pids)"                                    || exit $?
+test 1 = "$(wc -l < cppcheck.pids)"                                 || exit $?
+
+# the wrappers are removed from $PATH of the compiler
+grep -E "/(csclng|csgcca|cscppc):" gcc-path.txt                     && exit 1
+
+# the first wrapper has resolved the compilers and analyzers for all three
+test 3 = "$(wc -l < gcc-resolved.txt)"                              || exit $?
+awk -F '\t' '{ print $1 }' gcc-resolved.txt > hops.txt              || exit $?
+printf "cscppc\ncsgcca\ncsclng\n" | diff -u - hops.txt              || exit $?
+awk -F '\t' '{ print $5 }' gcc-resolved.txt > compilers.txt         || exit $?
+printf "%s\n" "$PWD/csgcca/gcc" "$PWD/csclng/gcc" "$PWD/tools/gcc" \
+    | diff -u - compilers.txt                                       || exit $?
+awk -F '\t' '{ print $8 }' gcc-resolved.txt > analyzers.txt         || exit $?
+printf "%s\n" "$PWD/tools/"{cppcheck,gcca,clang} \
+    | diff -u - analyzers.txt                                       || exit $?
+
+# invoke the last wrapper in the chain as the first one would do
+PATH_LAST="$(awk -F '\t' 'NR == 2 { print $4 }' gcc-resolved.txt)"
+
+# the resolved compiler is used if its fingerprint matches
+awk -F '\t' 'NR == 3 { OFS = FS; $4 = $4 ":/marker"; print }' \
+    gcc-resolved.txt > record.txt                                   || exit $?
+PATH="$PATH_LAST" CSCPPC_RESOLVED="$(<record.txt)" "csclng/gcc" -c test.c \
+                                                                    || exit $?
+grep ":/marker$" gcc-path.txt                                       || exit $?
+
+# the resolved compiler is not used if it does not match the fingerprint
+rm -f *.pids
+awk -F '\t' -v evil="$PWD/tools/evil" \
+    'NR == 3 { OFS = FS; $4 = $4 ":/marker"; $5 = evil; print }' \
+    gcc-resolved.txt > record.txt                                   || exit $?
+PATH="$PATH_LAST" CSCPPC_RESOLVED="$(<record.txt)" "csclng/gcc" -c test.c \
+                                                                    || exit $?
+test -e evil.pids                                                   && exit 1
+test 1 = "$(wc -l < gcc.pids)"                                      || exit $?
+grep ":/marker$" gcc-path.txt                                       && exit 1
+
+# the resolution of the chain is cached for subsequent invocations
+rm -f run/cscppc/resolved-*
+gcc -c test.c                                                       || exit $?
+CACHE="$(echo run/cscppc/resolved-*)"
+test -f "$CACHE"                                                    || exit $?
+tail -n +2 "$CACHE" | diff -u gcc-resolved.txt -                    || exit $?
+awk -F '\t' 'NR == 2 { OFS = FS; $4 = $4 ":/marker" } { print }' \
+    "$CACHE" > cache.txt && cp cache.txt "$CACHE"                   || exit $?
+gcc -c test.c                                                       || exit $?
+grep ":/marker$" gcc-path.txt                                       || exit $?
+
+# the resolved analyzer is used if its fingerprint matches
+rm -f *.pids
+FP="$(stat -L -c "%d:%i:%.9Y" tools/evil-cppcheck)"
+awk -F '\t' -v evil="$PWD/tools/evil-cppcheck" -v fp="$FP" \
+    'NR == 2 { OFS = FS; $8 = evil; $9 = fp } { print }' \
+    "$CACHE" > cache.txt && cp cache.txt "$CACHE"                   || exit $?
+gcc -c test.c                                                       || exit $?
+test 1 = "$(wc -l < evil-cppcheck.pids)"                            || exit $?
+test -e cppcheck.pids                                               && exit 1
+
+# ... and looked up in $PATH otherwise
+rm -f *.pids
+awk -F '\t' 'NR == 2 { OFS = FS; $9 = "0:0:0.000000000" } { print }' \
+    "$CACHE" > cache.txt && cp cache.txt "$CACHE"                   || exit $?
+gcc -c test.c                                                       || exit $?
+test -e evil-cppcheck.pids                                          && exit 1
+test 1 = "$(wc -l < cppcheck.pids)"                                 || exit $?
+
+# the cache is not used once a directory in $PATH has changed
+touch tools/new-tool                                                || exit $?
+gcc -c test.c                                                       || exit $?
+grep ":/marker$" gcc-path.txt                                       && exit 1
+tail -n +2 "$CACHE" | diff -u gcc-resolved.txt -                    || exit $?
+exit 0
@@ -0,0 +1,116 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tools wrap scripts a b
+touch test.c main.c slow.c a/util.c b/util.c                        || exit $?
+export PATH="$PWD/wrap:$PWD/tools:$PATH"
+
+# create faked compiler
+printf '#!/bin/sh
+case "$*" in *slow.c*) sleep 1 ;; esac\n' > tools/gcc            || exit $?
+
+# create faked smatch that prints info for the database if asked to do so
+printf '#!/bin/bash
+printf "%%s\\n" "$*" > smatch-args.txt
+for arg in "$@"; do
+    case "$arg" in
+        *.c)
+            file="$arg"
+            ;;
+    esac
+done
+echo "$file:1 main() warn: something is wrong"
+if [[ " $* " == *" --info "* ]]; then
+    echo "$file:1 main() info: returns unknown"
+    echo "$file:1 main() SQL: insert into return_states values ('"'"'$file'"'"', '"'"'main'"'"', 1, 1, '"'"'0'"'"', 0, 0, -1, '"'"''"'"', '"'"''"'"');"
+    echo "$file:2 main() SQL_caller_info: insert into caller_info values ('"'"'$file'"'"', '"'"'main'"'"', '"'"'foo'"'"', %%CALL_ID%%, 0, 1001, 0, '"'"'\$'"'"', '"'"'s32min-s32max'"'"');"
+fi
+' > tools/smatch                                                    || exit $?
+
+# create faked create_db.sh that records its input and creates the database
+printf '#!/bin/sh
+test -z "$CREATE_DB_FAIL" || exit 1
+cp "$1" "$TEST_DIR/create-db-input.txt"
+basename "$PWD" > "$TEST_DIR/create-db-cwd.txt"
+touch smatch_db.sqlite
+' > scripts/create_db.sh                                            || exit $?
+chmod 0755 tools/{gcc,smatch} scripts/create_db.sh                  || exit $?
+export TEST_DIR="$PWD"
+
+# create symlink to csmatch
+ln -fs "$PATH_TO_WRAP/csmatch" wrap/gcc                             || exit $?
+
+# the database is not used by default
+gcc -c test.c > output.txt                                          || exit $?
+grep -- "--info" smatch-args.txt                                    && exit 1
+grep "warn: something is wrong" output.txt                          || exit $?
+
+# collect info for the database during the build
+export CSMATCH_DB_DIR="$PWD/db"
+export CSMATCH_DB_SCRIPTS_DIR="$PWD/scripts"
+gcc -c test.c > output.txt                                          || exit $?
+gcc -c main.c > /dev/null                                           || exit $?
+grep -- " --info" smatch-args.txt                                   || exit $?
+grep -- "--db-file" smatch-args.txt                                 && exit 1
+grep "warn: something is wrong" output.txt                          || exit $?
+grep -E "info:|SQL" output.txt                                      && exit 1
+test 2 = "$(ls db/info/*.new | wc -l)"                              || exit $?
+
+# the database is not created if create_db.sh fails
+CREATE_DB_FAIL=1 "$PATH_TO_WRAP/csmatch" --update-db                && exit 1
+test -e db/smatch_db.sqlite                                         && exit 1
+test 2 = "$(ls db/info/*.new | wc -l)"                              || exit $?
+
+# create the database from all the stored info
+"$PATH_TO_WRAP/csmatch" --update-db                                 || exit $?
+test -e db/smatch_db.sqlite                                         || exit $?
+test 0 = "$(ls db/info/*.new 2>/dev/null | wc -l)"                  || exit $?
+test 2 = "$(ls db/info/*.info | wc -l)"                             || exit $?
+grep "^\.update-" create-db-cwd.txt                                 || exit $?
+test 0 = "$(ls -d db/.update-* 2>/dev/null | wc -l)"                || exit $?
+
+# the output of smatch is passed to create_db.sh as it is
+test 8 = "$(wc -l < create-db-input.txt)"                           || exit $?
+grep "^$PWD/test.c:1 main() warn: something is wrong$" \
+    create-db-input.txt                                             || exit $?
+grep "^$PWD/main.c:1 main() SQL: insert into return_states " \
+    create-db-input.txt                                             || exit $?
+grep "^$PWD/test.c:2 main() SQL_caller_info: .*, %CALL_ID%, " \
+    create-db-input.txt                                             || exit $?
+
+# nothing to be done if no TU has changed
+rm -f create-db-input.txt
+"$PATH_TO_WRAP/csmatch" --update-db                                 || exit $?
+test -e create-db-input.txt                                         && exit 1
+
+# the database is used once it exists, the changed TU replaces its old info
+gcc -c test.c > /dev/null                                           || exit $?
+grep -- "--db-file=$PWD/db/smatch_db.sqlite" smatch-args.txt        || exit $?
+"$PATH_TO_WRAP/csmatch" --update-db                                 || exit $?
+test 8 = "$(wc -l < create-db-input.txt)"                           || exit $?
+test 4 = "$(grep -c "^$PWD/test.c:" create-db-input.txt)"                || exit $?
+test 4 = "$(grep -c "^$PWD/main.c:" create-db-input.txt)"                || exit $?
+
+# the same file names in different directories refer to different TUs
+(cd a && gcc -c util.c > /dev/null)                                 || exit $?
+(cd b && gcc -c util.c > /dev/null)                                 || exit $?
+test 2 = "$(ls db/info/*.new | wc -l)"                              || exit $?
+"$PATH_TO_WRAP/csmatch" --update-db                                 || exit $?
+test 4 = "$(grep -c "^$PWD/a/util.c:" create-db-input.txt)"         || exit $?
+test 4 = "$(grep -c "^$PWD/b/util.c:" create-db-input.txt)"         || exit $?
+test 16 = "$(wc -l < create-db-input.txt)"                          || exit $?
+
+# the info of removed TUs is dropped as the whole database is rebuilt
+rm -f a/util.c
+"$PATH_TO_WRAP/csmatch" --update-db                                 || exit $?
+grep "^$PWD/a/util.c:" create-db-input.txt                          && exit 1
+test 12 = "$(wc -l < create-db-input.txt)"                          || exit $?
+test 3 = "$(ls db/info/*.info | wc -l)"                             || exit $?
+test 3 = "$(ls db/info/*.src | wc -l)"                              || exit $?
+
+# the info is stored even if smatch finishes before the compiler
+gcc -c slow.c > output.txt                                          || exit $?
+grep "warn: something is wrong" output.txt                          || exit $?
+test 1 = "$(ls db/info/*.new | wc -l)"                              || exit $?
+test 0 = "$(ls db/info/.out-* 2>/dev/null | wc -l)"                || exit $?
@@ -0,0 +1,44 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+WRAPS="cscppc csclng csclng++ csgcca csmatch"
+
+# all the wrappers are links to a single binary
+inode="$(stat -c %i "$PATH_TO_WRAP/cscppc")"                      || exit $?
+for wrap in $WRAPS; do
+    test "$(stat -c %i "$PATH_TO_WRAP/$wrap")" = "$inode"          || exit 1
+done
+
+# the profile is selected by the name of the link
+"$PATH_TO_WRAP/cscppc"   --help 2>&1 | grep "runs cppcheck in"       || exit 1
+"$PATH_TO_WRAP/csclng++" --help 2>&1 | grep "runs clang++ in"        || exit 1
+"$PATH_TO_WRAP/csgcca"   --help 2>&1 | grep "runs gcc -fanalyzer in" || exit 1
+"$PATH_TO_WRAP/csmatch"  --help 2>&1 | grep "runs smatch in"         || exit 1
+
+# the name of the link takes precedence over the environment
+CSCPPC_PROFILE=csgcca "$PATH_TO_WRAP/cscppc" --help 2>&1 \
+    | grep "runs cppcheck in"                                       || exit 1
+
+# a binary not named by any profile needs to have it set in the environment
+mkdir -p bin wrap
+cp -f "$PATH_TO_WRAP/cscppc" bin/cswrap-any                         || exit $?
+bin/cswrap-any --help 2> error-output.txt                           && exit 1
+grep "unknown profile, set CSCPPC_PROFILE to one of: cscppc" \
+    error-output.txt                                                || exit 1
+CSCPPC_PROFILE=csgcca bin/cswrap-any --help 2>&1 \
+    | grep "runs gcc -fanalyzer in"                                 || exit 1
+
+# fake compiler and analyzer recording their args
+printf '#!/bin/sh\necho "$0 $*" >> %s/cc.log\n' "$PWD" > bin/gcc
+printf '#!/bin/sh\necho "$0 $*" >> %s/an.log\n' "$PWD" > bin/gcca
+chmod +x bin/gcc bin/gcca                                           || exit $?
+ln -fs ../bin/cswrap-any wrap/gcc                                   || exit $?
+echo "int main() { return 0; }" > test.c                            || exit $?
+
+# compile via the binary selected by the environment
+rm -f cc.log an.log
+PATH="$PWD/wrap:$PWD/bin:$PATH" CSGCCA_ANALYZER_BIN=gcca \
+    CSCPPC_PROFILE=csgcca gcc -fanalyzer -c test.c                  || exit $?
+grep "bin/gcc -c test.c$" cc.log                                    || exit 1
+grep "gcca .*test.c -fanalyzer .* -o /dev/null$" an.log              || exit 1
@@ -0,0 +1,122 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+set -x
+
+mkdir -p tools wrap
+export PATH="$PWD/wrap:$PWD/tools:$PATH"
+
+# create faked compiler that fails on broken.c and that waits for the
+# analyzer to emit all its diagnostics on flood.c
+printf '#!/bin/sh
+printf "%%s\\n" "$*" >> gcc-args.txt
+case "$*" in *broken.c*) exit 1 ;; esac
+case "$*" in *flood.c*)
+    for i in $(seq 50); do test -e flooded.txt && exit 0; sleep 0.1; done
+    exit 1 ;;
+esac\n' > tools/gcc                                                 || exit $?
+
+# create faked analyzer emitting 18 bytes of diagnostics (or 256 KiB on
+# flood.c, which does not fit into a pipe)
+printf '#!/bin/sh
+case "$*" in *broken.c*) exec sleep 10 ;; esac
+case "$*" in *flood.c*)
+    head -c 262144 /dev/zero; touch flooded.txt; exit ;;
+esac
+printf "diag-out\\n"
+printf "diag-err\\n" >&2
+sleep 0.2\n' > tools/cppcheck                                       || exit $?
+printf '#!/bin/sh\n' > tools/clang                                 || exit $?
+chmod 0755 tools/{gcc,cppcheck,clang}                               || exit $?
+
+# create symlinks to wrappers
+ln -fs "$PATH_TO_WRAP/cscppc" wrap/gcc                              || exit $?
+for wrap in csclng csgcca; do
+    mkdir -p $wrap
+    ln -fs "$PATH_TO_WRAP/$wrap" $wrap/gcc                          || exit $?
+done
+
+# the statistics are not collected by default
+"$PATH_TO_WRAP/cscppc" --stats                                      && exit 1
+
+# use a unique build session and remove its segment even if the test fails
+export CSCPPC_STATS_SESSION="test-$$-$RANDOM"
+trap '"$PATH_TO_WRAP/cscppc" --stats-remove 2>/dev/null' EXIT
+"$PATH_TO_WRAP/cscppc" --stats                                      && exit 1
+
+# analyze two files, diagnostics are passed through
+gcc -c test.c > out.txt 2> err.txt                                  || exit $?
+grep "^diag-out$" out.txt                                           || exit 1
+grep "^diag-err$" err.txt                                           || exit 1
+gcc -c main.c                                                       || exit $?
+
+# conditions to skip the analyzer
+gcc -E test.c                                                       || exit $?
+gcc -MM test.c                                                      || exit $?
+gcc -c conftest.c                                                   || exit $?
+gcc -o test test.o main.o                                           || exit $?
+
+# compilation failed --> the analyzer is killed
+gcc -c broken.c                                                     && exit 1
+
+# queue two jobs and run them after the build
+export CSCPPC_DEFER_DIR="$PWD/queue"
+mkdir -p "$CSCPPC_DEFER_DIR"
+gcc -c test.c                                                       || exit $?
+gcc -c main.c                                                       || exit $?
+"$PATH_TO_WRAP/cscppc" --stats > stats.txt                          || exit $?
+grep "^analyzers queued: *2$" stats.txt                             || exit 1
+"$PATH_TO_WRAP/cscppc" --run-deferred=2                             || exit $?
+
+# check the snapshot
+"$PATH_TO_WRAP/csgcca" --stats > stats.txt                          || exit $?
+cat stats.txt
+grep "^build session: *$CSCPPC_STATS_SESSION$" stats.txt            || exit 1
+grep "^analyzers running: *0$" stats.txt                            || exit 1
+grep "^analyzers queued: *0$" stats.txt                             || exit 1
+grep "^analyzers finished: *7$" stats.txt                           || exit 1
+grep "^analyzers killed: *1$" stats.txt                             || exit 1
+grep "^analyzer wall time: *0\.000 s$" stats.txt                    && exit 1
+grep "^diagnostics (bytes): *108$" stats.txt                        || exit 1
+grep "^skipped (-E): *1$" stats.txt                                 || exit 1
+grep "^skipped (-M\*): *1$" stats.txt                               || exit 1
+grep "^skipped (ignored file): *1$" stats.txt                       || exit 1
+grep "^skipped (no input): *1$" stats.txt                           || exit 1
+
+# remove the statistics once the build has finished
+"$PATH_TO_WRAP/cscppc" --stats-remove                               || exit $?
+test -e "/dev/shm/cscppc-stats-$CSCPPC_STATS_SESSION"               && exit 1
+"$PATH_TO_WRAP/cscppc" --stats                                      && exit 1
+"$PATH_TO_WRAP/cscppc" --stats-remove                               && exit 1
+
+# diagnostics are relayed while waiting for the compiler
+export CSCPPC_STATS_SESSION="test-$$-$RANDOM-flood"
+unset CSCPPC_DEFER_DIR
+rm -f flooded.txt
+gcc -c flood.c > out.txt                                            || exit $?
+test 262144 = "$(wc -c < out.txt)"                                  || exit 1
+"$PATH_TO_WRAP/cscppc" --stats > stats.txt                          || exit $?
+grep "^diagnostics (bytes): *262144$" stats.txt                     || exit 1
+"$PATH_TO_WRAP/cscppc" --stats-remove                               || exit $?
+
+# the skips are counted once per analyzer in the preprocess-once mode, too
+export CSCPPC_STATS_SESSION="test-$$-$RANDOM-pponce"
+export CSCPPC_PREPROCESS_ONCE=1
+export PATH="$PWD/csclng:$PWD/csgcca:$PWD/tools:$PATH"
+
+# csgcca runs the GCC analyzer on the input preprocessed by csclng
+rm -f gcc-args.txt
+gcc -c test.c                                                       || exit $?
+grep "^-E -C test.c -o /.*\.i$" gcc-args.txt                        || exit 1
+
+gcc -E test.c                                                       || exit $?
+gcc -M test.c                                                       || exit $?
+gcc -c conftest.c                                                   || exit $?
+gcc -c                                                              || exit $?
+"$PATH_TO_WRAP/cscppc" --stats > stats.txt                          || exit $?
+cat stats.txt
+grep "^analyzers finished: *2$" stats.txt                           || exit 1
+grep "^skipped (-E): *2$" stats.txt                                 || exit 1
+grep "^skipped (-M\*): *2$" stats.txt                               || exit 1
+grep "^skipped (ignored file): *2$" stats.txt                       || exit 1
+grep "^skipped (no input): *2$" stats.txt                           || exit 1
+"$PATH_TO_WRAP/cscppc" --stats-remove                               || exit $?
@@ -0,0 +1,253 @@
+#!/bin/bash
+source "$1/../testlib.sh"
+
+# do not let the test-suite settings distort the results
+unset MALLOC_PERTURB_
+
+# size and shape of the synthetic projects
+: "${BENCH_FILES:=40}"                  # number of source files per project
+: "${BENCH_INCLUDE_DEPTH:=8}"           # depth of the chain of headers
+: "${BENCH_MACROS:=50}"                 # number of macros per header
+: "${BENCH_JOBS:=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)}"
+
+# CPU cost of each run of a faked analyzer (iterations of a busy loop)
+: "${BENCH_ANALYZER_COST:=200000}"
+
+# set to 1 to use the real analyzers instead of the faked ones
+: "${BENCH_REAL_ANALYZERS:=0}"
+
+# wrappers to measure, ',' chains wrappers, '+pponce' and '+defer' enable
+# additional modes
+: "${BENCH_MODES:=none cscppc csclng csgcca csmatch cscppc+defer
+    cscppc,csclng,csgcca cscppc,csclng,csgcca+pponce}"
+
+# languages of the synthetic projects
+: "${BENCH_LANGS:=c cxx}"
+
+export BENCH_ANALYZER_COST
+PATH_ORIG="$PATH"
+
+die() {
+    printf "runbench.sh: error: %s\n" "$*" >&2
+    exit 1
+}
+
+# create faked analyzers with configurable cost
+mkdir -p fake
+for tool in cppcheck clang clang++ smatch gcc-analyzer; do
+    printf '#!/bin/bash
+awk -v n="$BENCH_ANALYZER_COST" "BEGIN { for (i = 0; i < n; ++i) x += i }"
+' > fake/$tool                                                      || exit $?
+    chmod 0755 fake/$tool                                           || exit $?
+done
+
+# the GCC analyzer is run via the timing shim of the compiler (see gen_shim)
+GCC_ANALYZER="$PWD/fake/gcc-analyzer"
+test 1 = "$BENCH_REAL_ANALYZERS" && GCC_ANALYZER="$(command -v gcc)"
+
+# use faked compilers with the same cost as analyzers if there are no real
+REAL_CC="$(command -v cc)"
+REAL_CXX="$(command -v c++)"
+if test -z "$REAL_CC" || test -z "$REAL_CXX"; then
+    printf '#!/bin/bash
+awk -v n="$BENCH_ANALYZER_COST" "BEGIN { for (i = 0; i < n; ++i) x += i }"
+while test -n "$1"; do
+    test "-o" = "$1" && touch "$2"
+    shift
+done
+' > fake/compiler                                                   || exit $?
+    chmod 0755 fake/compiler                                        || exit $?
+    REAL_CC="$PWD/fake/compiler"
+    REAL_CXX="$PWD/fake/compiler"
+fi
+
+# generate a synthetic project in $1 written in language $2 (c or cxx)
+gen_project() {
+    local dir="$1" ext="c" d m i
+    test cxx = "$2" && ext="cpp"
+    rm -rf "$dir"
+    mkdir -p "$dir/include" "$dir/src"                              || return $?
+
+    # chain of headers, each of them including the next one
+    for ((d = 0; d < BENCH_INCLUDE_DEPTH; ++d)); do
+        {
+            printf "#ifndef H%d_H\n#define H%d_H\n" $d $d
+            test $((d + 1)) -lt "$BENCH_INCLUDE_DEPTH" \
+                && printf '#include "h%d.h"\n' $((d + 1))
+            printf "#include <stddef.h>\n#include <string.h>\n"
+            for ((m = 0; m < BENCH_MACROS; ++m)); do
+                printf "#define M%d_%d(x) ((x) * %d + H%d_BASE)\n" $d $m $m $d
+            done
+            printf "#define H%d_BASE %d\n#endif\n" $d $d
+        } > "$dir/include/h$d.h"                                    || return $?
+    done
+
+    # sources expanding all the macros of all the headers
+    for ((i = 0; i < BENCH_FILES; ++i)); do
+        {
+            printf '#include "h0.h"\n\nint func%d(int x)\n{\n' $i
+            printf "    int r = (int) strlen(\"%d\");\n" $i
+            for ((d = 0; d < BENCH_INCLUDE_DEPTH; ++d)); do
+                for ((m = 0; m < BENCH_MACROS; ++m)); do
+                    printf "    r += M%d_%d(x);\n" $d $m
+                done
+            done
+            printf "    return r;\n}\n"
+        } > "$dir/src/f$i.$ext"                                     || return $?
+    done
+
+    # Makefile building all the sources
+    {
+        printf "OBJS ="
+        for ((i = 0; i < BENCH_FILES; ++i)); do
+            printf " src/f%d.o" $i
+        done
+        printf "\n\nall: \$(OBJS)\n\n"
+        printf "FLAGS = -O2 -Iinclude -DBENCH=1\n\n"
+        printf "%%.o: %%.c\n\t\$(CC) \$(FLAGS) -c \$< -o \$@\n\n"
+        printf "%%.o: %%.cpp\n\t\$(CXX) \$(FLAGS) -c \$< -o \$@\n\n"
+        printf "clean:\n\trm -f \$(OBJS)\n"
+    } > "$dir/Makefile"                                             || return $?
+}
+
+# create a timing shim named $2 in directory $1 that runs $3 with $PATH set
+# to $5 and logs to $4.  The shim of the compiler is also used by csgcca as
+# the GCC analyzer so that it can read the input preprocessed by the compiler
+# in the preprocess-once mode.  It runs $GCC_ANALYZER without any timing then.
+gen_shim() {
+    printf '#!/bin/bash
+for arg in "$@"; do
+    test "-fanalyzer" = "$arg" && PATH="%s" exec "%s" "$@"
+done
+t0="$EPOCHREALTIME"
+PATH="%s" "%s" "$@"
+rc="$?"
+echo "$t0 $EPOCHREALTIME" >> "%s"
+exit "$rc"
+' "$5" "$GCC_ANALYZER" "$5" "$3" "$4" > "$1/$2"                    || return $?
+    chmod 0755 "$1/$2"
+}
+
+# sum durations logged by gen_shim()
+sum_log() {
+    awk '{ sum += $2 - $1 } END { printf "%.2f", sum }' "$1" 2>/dev/null \
+        || printf "0.00"
+}
+
+# run the command, write "wall user sys maxrss" to $1
+measure() {
+    local out="$1"
+    shift
+    if test -x /usr/bin/time; then
+        /usr/bin/time -f "%e %U %S %M" -o "$out" "$@"
+    elif python3 -c "import resource" 2>/dev/null; then
+        python3 -c 'import resource, subprocess, sys, time
+t = time.time()
+rc = subprocess.call(sys.argv[2:])
+r = resource.getrusage(resource.RUSAGE_CHILDREN)
+with open(sys.argv[1], "w") as f:
+    print("%.2f %.2f %.2f %d" % (time.time() - t, r.ru_utime, r.ru_stime,
+        r.ru_maxrss), file=f)
+sys.exit(rc)' "$out" "$@"
+    else
+        local TIMEFORMAT="%R %U %S -"
+        { time "$@" 2>&1 ; } 2> "$out"
+    fi
+}
+
+# build the project $2 with the (chained) wrappers and mode given by $1
+run_mode() {
+    local mode="$1" proj="$2" chain="${1%%+*}" opts="" env=() wrap wraps
+    test "$mode" != "$chain" && opts="+${mode#*+}"
+    IFS=, read -r -a wraps <<< "$chain"
+    local run="$PWD/run/$mode-${proj##*/}"
+    rm -rf "$run"
+    mkdir -p "$run"/{outer,inner,defer}                             || return $?
+
+    # inner shims time the compiler itself
+    gen_shim "$run/inner" cc  "$REAL_CC"  "$run/compiler.log" "$PATH_ORIG"
+    gen_shim "$run/inner" c++ "$REAL_CXX" "$run/compiler.log" "$PATH_ORIG"
+
+    # outer shims time the wrappers (or the compiler without any wrapper)
+    local path="$run/inner:$PWD/fake:$PATH_ORIG" i
+    if test none != "$chain"; then
+        # the first wrapper in the chain comes first in $PATH
+        for ((i = ${#wraps[@]} - 1; 0 <= i; --i)); do
+            wrap="${wraps[i]}"
+            test -x "$PATH_TO_WRAP/$wrap" || die "wrapper not found: $wrap"
+            mkdir -p "$run/wrap-$wrap"                              || return $?
+            ln -fs "$PATH_TO_WRAP/$wrap" "$run/wrap-$wrap/cc"
+            ln -fs "$PATH_TO_WRAP/$wrap" "$run/wrap-$wrap/c++"
+            path="$run/wrap-$wrap:$path"
+        done
+    fi
+    local next="${path%%:*}"
+    test 1 = "$BENCH_REAL_ANALYZERS" && path="${path/:$PWD\/fake:/:}"
+    gen_shim "$run/outer" cc  "$next/cc"  "$run/wrapper.log" "$path"
+    gen_shim "$run/outer" c++ "$next/c++" "$run/wrapper.log" "$path"
+
+    env+=("CSGCCA_ANALYZER_BIN=$run/inner/cc")
+    case "$opts" in
+        *+pponce*) env+=("CSCPPC_PREPROCESS_ONCE=1") ;;
+    esac
+    case "$opts" in
+        *+defer*)
+            for wrap in "${wraps[@]}"; do
+                env+=("${wrap^^}_DEFER_DIR=$run/defer")
+            done
+            ;;
+    esac
+
+    make -s -C "$proj" clean >/dev/null                             || return $?
+    (
+        export PATH="$run/outer:$PATH_ORIG"
+        for e in "${env[@]}"; do
+            export "$e"
+        done
+        measure "$run/time.txt" \
+            make -s -j"$BENCH_JOBS" -C "$proj" CC=cc CXX=c++ >/dev/null
+    ) || die "build failed: $mode ($proj)"
+
+    # run the deferred analyses after the build
+    local batch="-"
+    if test -n "$(ls "$run/defer")"; then
+        local t0="$EPOCHREALTIME"
+        env "${env[@]}" PATH="$path" \
+            "$PATH_TO_WRAP/${wraps[0]}" --run-deferred="$BENCH_JOBS" >/dev/null
+        batch="$(awk -v t0="$t0" -v t1="$EPOCHREALTIME" \
+            'BEGIN { printf "%.2f", t1 - t0 }')"
+    fi
+
+    # analyzer wait = time spent in wrappers minus time spent in compilers
+    local wait
+    wait="$(awk -v w="$(sum_log "$run/wrapper.log")" \
+        -v c="$(sum_log "$run/compiler.log")" \
+        'BEGIN { printf "%.2f", (w > c) ? w - c : 0 }')"
+
+    read -r wall user sys rss < "$run/time.txt"
+    printf "%s %s %s %s %s %s\n" "$wall" \
+        "$(awk -v u="$user" -v s="$sys" 'BEGIN { printf "%.2f", u + s }')" \
+        "$rss" "$wait" "$batch"
+}
+
+printf "files=%s include-depth=%s macros=%s jobs=%s analyzer-cost=%s\n" \
+    "$BENCH_FILES" "$BENCH_INCLUDE_DEPTH" "$BENCH_MACROS" "$BENCH_JOBS" \
+    "$BENCH_ANALYZER_COST" | tee bench-results.txt
+
+for lang in $BENCH_LANGS; do
+    gen_project "$PWD/proj-$lang" "$lang"                           || exit $?
+    printf "\n%-28s %8s %8s %8s %12s %10s %10s\n" "[$lang]" "wall[s]" \
+        "cpu[s]" "slowdown" "maxrss[KiB]" "wait[s]" "batch[s]" \
+        | tee -a bench-results.txt
+    base=
+    for mode in $BENCH_MODES; do
+        read -r wall cpu rss wait batch \
+            < <(run_mode "$mode" "$PWD/proj-$lang")
+        test -n "$wall" || exit 1
+        test none = "$mode" && base="$wall"
+        slowdown="$(awk -v w="$wall" -v b="$base" \
+            'BEGIN { if (0 < b) printf "%.2fx", w / b; else printf "-" }')"
+        printf "%-28s %8s %8s %8s %12s %10s %10s\n" "$mode" "$wall" "$cpu" \
+            "$slowdown" "$rss" "$wait" "$batch" | tee -a bench-results.txt
+    done
+done